@@ -0,0 +1,35 @@
+/********************************************************************
+ * File   : cocos-ext.h
+ * Project: CppUnitTest
+ *
+ ********************************************************************
+ * Created on 10/20/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+#ifndef __CppUnitTest__CocosShimExt__
+#define __CppUnitTest__CocosShimExt__
+
+/* Stands in for cocos-ext.h in the tests (see cocos2d.h here).  Nothing
+ * under test uses the extensions.
+ */
+namespace cocos2d { namespace extension {} }
+
+#endif /* defined(__CppUnitTest__CocosShimExt__) */
@@ -0,0 +1,104 @@
+/********************************************************************
+ * File   : cocos2d.h
+ * Project: CppUnitTest
+ *
+ ********************************************************************
+ * Created on 10/20/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+#ifndef __CppUnitTest__CocosShim__
+#define __CppUnitTest__CocosShim__
+
+#include <cmath>
+
+/* The CppUnitTest target is a Mac command line tool, and the cocos2d-x
+ * in the main project only builds for iOS.  The classes under test
+ * (LineSmoother, LineSimplifier) only need CCPoint and a few of the ccp
+ * helpers, so this header stands in for cocos2d.h in the tests.  They
+ * behave the same as the cocos2d-x 2.x versions.
+ *
+ * Add to it if a class under test needs more, but keep it to plain
+ * value types; anything that needs a GL context doesn't belong in a
+ * unit test.
+ */
+
+#define CCLOG(...) do {} while(0)
+
+#ifndef MIN
+#define MIN(x,y) (((x) > (y)) ? (y) : (x))
+#endif
+#ifndef MAX
+#define MAX(x,y) (((x) < (y)) ? (y) : (x))
+#endif
+
+namespace cocos2d {
+
+class CCPoint
+{
+public:
+   float x;
+   float y;
+   
+   CCPoint() : x(0), y(0) {}
+   CCPoint(float x_, float y_) : x(x_), y(y_) {}
+   
+   CCPoint operator+(const CCPoint& right) const { return CCPoint(x + right.x, y + right.y); }
+   CCPoint operator-(const CCPoint& right) const { return CCPoint(x - right.x, y - right.y); }
+   CCPoint operator-() const { return CCPoint(-x, -y); }
+   CCPoint operator*(float a) const { return CCPoint(x*a, y*a); }
+   CCPoint operator/(float a) const { return CCPoint(x/a, y/a); }
+   bool equals(const CCPoint& target) const { return x == target.x && y == target.y; }
+};
+
+typedef struct _ccColor4F
+{
+   float r;
+   float g;
+   float b;
+   float a;
+} ccColor4F;
+
+#define CCPointZero cocos2d::CCPoint(0,0)
+
+static inline float clampf(float value, float min_inclusive, float max_inclusive)
+{
+   if(min_inclusive > max_inclusive)
+   {
+      float temp = min_inclusive;
+      min_inclusive = max_inclusive;
+      max_inclusive = temp;
+   }
+   return value < min_inclusive ? min_inclusive : value < max_inclusive ? value : max_inclusive;
+}
+
+static inline CCPoint ccp(float x, float y) { return CCPoint(x, y); }
+static inline CCPoint ccpAdd(const CCPoint& v1, const CCPoint& v2) { return v1 + v2; }
+static inline CCPoint ccpSub(const CCPoint& v1, const CCPoint& v2) { return v1 - v2; }
+static inline CCPoint ccpMult(const CCPoint& v, float s) { return v*s; }
+static inline float ccpDot(const CCPoint& v1, const CCPoint& v2) { return v1.x*v2.x + v1.y*v2.y; }
+static inline float ccpLengthSQ(const CCPoint& v) { return ccpDot(v, v); }
+static inline float ccpLength(const CCPoint& v) { return sqrtf(ccpLengthSQ(v)); }
+static inline float ccpDistance(const CCPoint& v1, const CCPoint& v2) { return ccpLength(v1 - v2); }
+static inline float ccpDistanceSQ(const CCPoint& v1, const CCPoint& v2) { return ccpLengthSQ(v1 - v2); }
+
+}
+
+#endif /* defined(__CppUnitTest__CocosShim__) */
@@ -0,0 +1,549 @@
+/********************************************************************
+ * File   : NotifierStress.cpp
+ * Project: CppUnitTest
+ *
+ ********************************************************************
+ * Created on 10/17/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+/* A stand alone benchmark and fuzz tester for the Notifier.  It only
+ * needs Notifier.cpp (no cocos2d, no CppUnit), so it builds anywhere:
+ *
+ *    g++ -std=gnu++98 -O2 -IToolsDemo CppUnitTest/NotifierStress.cpp ToolsDemo/Notifier.cpp -o notifier_stress
+ *    ./notifier_stress [seed] [fuzzOperations] [maxBenchmarkObservers] [maxFuzzObservers]
+ *
+ * It is NOT part of the CppUnitTest target (it has its own main).
+ *
+ * The benchmark times dispatching to 1K, 10K, 100K ... up to
+ * maxBenchmarkObservers (default 1M) observers and reports ns per
+ * dispatch, ns per observer call and heap allocations per dispatch.
+ *
+ * The fuzzer keeps up to maxFuzzObservers (default 1000) alive and 
+ * randomly mixes Attach, Detach, delete, nested Notify and
+ * delete/detach/attach from inside Notify, and checks every callback
+ * against a reference model of who should be attached.  Everybody
+ * attaches at the same priority, so each Notify(...) must call exactly
+ * the observers that were attached when it started (in attach order),
+ * minus any that were detached before their turn.  Any difference is
+ * reported with the seed so it can be reproduced.  Build it with
+ * -fsanitize=address to catch calls into deleted observers as well.
+ */
+
+#include "Notifier.h"
+#include <cstdlib>
+#include <new>
+#include <iomanip>
+#ifdef __APPLE__
+#include <mach/mach_time.h>
+#else
+#include <time.h>
+#endif
+
+// Count heap allocations so we can report them per dispatch.
+static uint64 allocationCount = 0;
+
+void* operator new(size_t size) throw(std::bad_alloc)
+{
+   allocationCount++;
+   void* result = malloc(size == 0 ? 1 : size);
+   if(result == NULL)
+   {
+      throw std::bad_alloc();
+   }
+   return result;
+}
+
+void operator delete(void* ptr) throw()
+{
+   free(ptr);
+}
+
+static uint64 NowNanoseconds()
+{
+#ifdef __APPLE__
+   static mach_timebase_info_data_t timeBaseInfo;
+   if(timeBaseInfo.denom == 0)
+   {
+      mach_timebase_info(&timeBaseInfo);
+   }
+   return mach_absolute_time() * timeBaseInfo.numer / timeBaseInfo.denom;
+#else
+   struct timespec now;
+   clock_gettime(CLOCK_MONOTONIC, &now);
+   return (uint64)now.tv_sec*1000000000ULL + now.tv_nsec;
+#endif
+}
+
+// xorshift, so a seed gives the same run on every platform.
+static uint64 randomState = 1;
+
+static uint32 Random(uint32 range)
+{
+   randomState ^= randomState << 13;
+   randomState ^= randomState >> 7;
+   randomState ^= randomState << 17;
+   return (uint32)(randomState % range);
+}
+
+static Notifier::NOTIFIED_EVENT_TYPE_T RandomEvent()
+{
+   return (Notifier::NOTIFIED_EVENT_TYPE_T)Random(Notifier::NE_MAX);
+}
+
+static uint32 failures = 0;
+
+#define STRESS_CHECK(condition) \
+   if(!(condition)) \
+   { \
+      cout << "FAILED: " << #condition << " (" << __FILE__ << ":" << __LINE__ << ")" << endl; \
+      failures++; \
+   }
+
+/**************************************************************
+ * Benchmark
+ **************************************************************/
+
+class BenchmarkObserver : public Notified
+{
+public:
+   uint32 count;
+   BenchmarkObserver() : count(0) {}
+   virtual void Notify(Notifier::NOTIFIED_EVENT_TYPE_T eventType, const void* eventData) { count++; }
+};
+
+static void RunBenchmark(uint32 maxObservers)
+{
+   cout << "Benchmark" << endl;
+   cout << setw(10) << "Observers" << setw(12) << "Dispatches" << setw(14) << "ns/dispatch" << setw(10) << "ns/call" << setw(16) << "allocs/dispatch" << setw(12) << "attach ms" << setw(14) << "teardown ms" << endl;
+
+   for(uint32 observers = 1000; observers <= maxObservers; observers *= 10)
+   {
+      Notifier notifier;
+      notifier.Init();
+      vector<BenchmarkObserver*> targets;
+      targets.reserve(observers);
+
+      uint64 start = NowNanoseconds();
+      for(uint32 idx = 0; idx < observers; idx++)
+      {
+         targets.push_back(new BenchmarkObserver());
+         notifier.Attach(targets[idx], Notifier::NE_DEBUG_BUTTON_PRESSED);
+      }
+      uint64 attachNs = NowNanoseconds() - start;
+
+      // Roughly the same total number of calls for every size.
+      uint32 dispatches = 10000000/observers;
+      if(dispatches < 10)
+      {
+         dispatches = 10;
+      }
+      uint64 allocations = allocationCount;
+      start = NowNanoseconds();
+      for(uint32 idx = 0; idx < dispatches; idx++)
+      {
+         notifier.Notify(Notifier::NE_DEBUG_BUTTON_PRESSED);
+      }
+      uint64 dispatchNs = NowNanoseconds() - start;
+      allocations = allocationCount - allocations;
+      STRESS_CHECK(targets[observers-1]->count == dispatches);
+
+      start = NowNanoseconds();
+      for(uint32 idx = 0; idx < observers; idx++)
+      {
+         delete targets[idx];
+      }
+      uint64 teardownNs = NowNanoseconds() - start;
+      STRESS_CHECK(notifier.GetNotified(Notifier::NE_DEBUG_BUTTON_PRESSED).size() == 0);
+
+      cout << setw(10) << observers << setw(12) << dispatches
+           << setw(14) << dispatchNs/dispatches
+           << setw(10) << (double)dispatchNs/((double)dispatches*observers)
+           << setw(16) << (double)allocations/dispatches
+           << setw(12) << attachNs/1000000.0
+           << setw(14) << teardownNs/1000000.0 << endl;
+   }
+}
+
+/**************************************************************
+ * Fuzzer
+ **************************************************************/
+
+class FuzzObserver;
+
+// The reference model of one Notify(...) in progress.
+typedef struct
+{
+   Notifier::NOTIFIED_EVENT_TYPE_T eventType;
+   // Attach sequence numbers above this were attached after it started.
+   uint64 startSequence;
+   // Calls are made in attach order, so anybody with a sequence number
+   // at or below this has had their turn.
+   uint64 lastCalledSequence;
+   uint32 attachedAtStart;
+   uint32 calls;
+   // Detached before they got their turn.
+   uint32 skipped;
+} FRAME_T;
+
+static const uint32 FUZZ_ALIVE = 0xA11FE;
+static const uint32 FUZZ_DEAD = 0xDEAD;
+static const uint32 FUZZ_MAX_DEPTH = 4;
+
+static Notifier* fuzzNotifier = NULL;
+static vector<FuzzObserver*> live;
+static uint32 maxLive = 1000;
+static uint64 attachSequence = 0;
+static uint32 modelCount[Notifier::NE_MAX];
+static vector<FRAME_T> frames;
+
+// Counters for the summary.
+static uint64 notifies = 0;
+static uint64 nestedNotifies = 0;
+static uint64 callbacks = 0;
+static uint64 deletedInNotify = 0;
+static uint64 detachedInNotify = 0;
+static uint64 attachedInNotify = 0;
+
+static void FuzzNotify(Notifier::NOTIFIED_EVENT_TYPE_T eventType);
+static void FuzzCallbackActions();
+
+class FuzzObserver : public Notified
+{
+public:
+   uint32 magic;
+   uint32 liveIndex;
+   // The reference model: when this observer attached to each event
+   // (0 if it is not attached).
+   uint64 attachedAt[Notifier::NE_MAX];
+
+   FuzzObserver() : magic(FUZZ_ALIVE)
+   {
+      for(uint32 event = 0; event < Notifier::NE_MAX; event++)
+      {
+         attachedAt[event] = 0;
+      }
+   }
+
+   virtual ~FuzzObserver()
+   {
+      magic = FUZZ_DEAD;
+   }
+
+   virtual void Notify(Notifier::NOTIFIED_EVENT_TYPE_T eventType, const void* eventData)
+   {
+      Called(eventType);
+   }
+
+   // Typed handler, used for NE_RESET_DRAW_CYCLE half the time.
+   void ResetDrawCycle(const Notifier::NO_PAYLOAD_T& payload)
+   {
+      Called(Notifier::NE_RESET_DRAW_CYCLE);
+   }
+
+   void Called(Notifier::NOTIFIED_EVENT_TYPE_T eventType)
+   {
+      callbacks++;
+      STRESS_CHECK(magic == FUZZ_ALIVE);
+      STRESS_CHECK(frames.size() > 0);
+      if(magic != FUZZ_ALIVE || frames.size() == 0)
+      {
+         return;
+      }
+      FRAME_T& frame = frames.back();
+      STRESS_CHECK(frame.eventType == eventType);
+      // Must still be attached, must have been attached before the
+      // Notify(...) started, and must be called in attach order (which
+      // also means only once).
+      STRESS_CHECK(attachedAt[eventType] != 0);
+      STRESS_CHECK(attachedAt[eventType] <= frame.startSequence);
+      STRESS_CHECK(attachedAt[eventType] > frame.lastCalledSequence);
+      frame.lastCalledSequence = attachedAt[eventType];
+      frame.calls++;
+
+      FuzzCallbackActions();
+   }
+};
+
+static void ModelDetach(FuzzObserver* observer, Notifier::NOTIFIED_EVENT_TYPE_T eventType)
+{
+   uint64 sequence = observer->attachedAt[eventType];
+   if(sequence == 0)
+   {
+      return;
+   }
+   // Any Notify(...) of this event in progress that has not reached this
+   // observer yet will skip it.
+   for(uint32 idx = 0; idx < frames.size(); idx++)
+   {
+      if(frames[idx].eventType == eventType &&
+         sequence <= frames[idx].startSequence &&
+         sequence > frames[idx].lastCalledSequence)
+      {
+         frames[idx].skipped++;
+      }
+   }
+   observer->attachedAt[eventType] = 0;
+   modelCount[eventType]--;
+}
+
+static FuzzObserver* RandomObserver()
+{
+   if(live.size() == 0)
+   {
+      return NULL;
+   }
+   return live[Random(live.size())];
+}
+
+static void FuzzCreate()
+{
+   if(live.size() >= maxLive)
+   {
+      return;
+   }
+   FuzzObserver* observer = new FuzzObserver();
+   observer->liveIndex = live.size();
+   live.push_back(observer);
+}
+
+static void FuzzAttach(FuzzObserver* observer, Notifier::NOTIFIED_EVENT_TYPE_T eventType)
+{
+   if(eventType == Notifier::NE_RESET_DRAW_CYCLE && Random(2) == 0)
+   {
+      Notifier::Channel<Notifier::NE_RESET_DRAW_CYCLE>(*fuzzNotifier).Attach<FuzzObserver,&FuzzObserver::ResetDrawCycle>(observer);
+   }
+   else
+   {
+      fuzzNotifier->Attach(observer, eventType);
+   }
+   // Attaching again does not move it.
+   if(observer->attachedAt[eventType] == 0)
+   {
+      observer->attachedAt[eventType] = ++attachSequence;
+      modelCount[eventType]++;
+   }
+}
+
+static void FuzzDetach(FuzzObserver* observer, Notifier::NOTIFIED_EVENT_TYPE_T eventType)
+{
+   fuzzNotifier->Detach(observer, eventType);
+   ModelDetach(observer, eventType);
+}
+
+static void FuzzDetachAll(FuzzObserver* observer)
+{
+   fuzzNotifier->Detach(observer);
+   for(uint32 event = 0; event < Notifier::NE_MAX; event++)
+   {
+      ModelDetach(observer, (Notifier::NOTIFIED_EVENT_TYPE_T)event);
+   }
+}
+
+static void FuzzDelete(FuzzObserver* observer)
+{
+   for(uint32 event = 0; event < Notifier::NE_MAX; event++)
+   {
+      ModelDetach(observer, (Notifier::NOTIFIED_EVENT_TYPE_T)event);
+   }
+   // Swap it out of the live list.
+   FuzzObserver* last = live.back();
+   live[observer->liveIndex] = last;
+   last->liveIndex = observer->liveIndex;
+   live.pop_back();
+   // The destructor detaches it from the Notifier.
+   delete observer;
+}
+
+// Things an observer might do when it is notified.
+static void FuzzCallbackActions()
+{
+   switch(Random(16))
+   {
+      case 0:
+         if(RandomObserver() != NULL)
+         {
+            FuzzDelete(RandomObserver());
+            deletedInNotify++;
+         }
+         break;
+      case 1:
+         if(RandomObserver() != NULL)
+         {
+            FuzzDetach(RandomObserver(), RandomEvent());
+            detachedInNotify++;
+         }
+         break;
+      case 2:
+         FuzzCreate();
+         FuzzAttach(RandomObserver(), RandomEvent());
+         attachedInNotify++;
+         break;
+      case 3:
+         if(frames.size() < FUZZ_MAX_DEPTH)
+         {
+            nestedNotifies++;
+            FuzzNotify(RandomEvent());
+         }
+         break;
+      default:
+         break;
+   }
+}
+
+static void FuzzNotify(Notifier::NOTIFIED_EVENT_TYPE_T eventType)
+{
+   FRAME_T frame;
+   frame.eventType = eventType;
+   frame.startSequence = attachSequence;
+   frame.lastCalledSequence = 0;
+   frame.attachedAtStart = modelCount[eventType];
+   frame.calls = 0;
+   frame.skipped = 0;
+   frames.push_back(frame);
+   notifies++;
+
+   fuzzNotifier->Notify(eventType);
+
+   // Everybody that was attached at the start got called, unless they
+   // were detached first.
+   frame = frames.back();
+   frames.pop_back();
+   STRESS_CHECK(frame.calls + frame.skipped == frame.attachedAtStart);
+}
+
+// Compare the whole Notifier against the model.
+static void FuzzCheckAll()
+{
+   for(uint32 event = 0; event < Notifier::NE_MAX; event++)
+   {
+      vector<Notified*> notified = fuzzNotifier->GetNotified((Notifier::NOTIFIED_EVENT_TYPE_T)event);
+      STRESS_CHECK(notified.size() == modelCount[event]);
+      uint64 lastSequence = 0;
+      for(uint32 idx = 0; idx < notified.size(); idx++)
+      {
+         FuzzObserver* observer = static_cast<FuzzObserver*>(notified[idx]);
+         STRESS_CHECK(observer->magic == FUZZ_ALIVE);
+         STRESS_CHECK(observer->attachedAt[event] > lastSequence);
+         lastSequence = observer->attachedAt[event];
+      }
+   }
+   FuzzObserver* observer = RandomObserver();
+   if(observer != NULL)
+   {
+      vector<Notifier::NOTIFIED_EVENT_TYPE_T> events = fuzzNotifier->GetEvents(observer);
+      uint32 expected = 0;
+      for(uint32 event = 0; event < Notifier::NE_MAX; event++)
+      {
+         if(observer->attachedAt[event] != 0)
+         {
+            expected++;
+         }
+      }
+      STRESS_CHECK(events.size() == expected);
+   }
+}
+
+static void RunFuzzer(uint32 operations)
+{
+   Notifier notifier;
+   notifier.Init();
+   fuzzNotifier = &notifier;
+
+   for(uint32 op = 0; op < operations && failures == 0; op++)
+   {
+      switch(Random(10))
+      {
+         case 0:
+         case 1:
+            FuzzCreate();
+            break;
+         case 2:
+         case 3:
+            if(RandomObserver() != NULL)
+            {
+               FuzzAttach(RandomObserver(), RandomEvent());
+            }
+            break;
+         case 4:
+            if(RandomObserver() != NULL)
+            {
+               FuzzDetach(RandomObserver(), RandomEvent());
+            }
+            break;
+         case 5:
+            if(RandomObserver() != NULL)
+            {
+               FuzzDetachAll(RandomObserver());
+            }
+            break;
+         case 6:
+            if(RandomObserver() != NULL)
+            {
+               FuzzDelete(RandomObserver());
+            }
+            break;
+         default:
+            FuzzNotify(RandomEvent());
+            break;
+      }
+      if(op % 1000 == 0)
+      {
+         FuzzCheckAll();
+      }
+   }
+   FuzzCheckAll();
+
+   while(live.size() > 0)
+   {
+      FuzzDelete(live.back());
+   }
+   for(uint32 event = 0; event < Notifier::NE_MAX; event++)
+   {
+      STRESS_CHECK(notifier.GetNotified((Notifier::NOTIFIED_EVENT_TYPE_T)event).size() == 0);
+   }
+   fuzzNotifier = NULL;
+}
+
+int main(int argc, const char* argv[])
+{
+   uint32 seed = argc > 1 ? (uint32)strtoul(argv[1], NULL, 10) : 1;
+   uint32 operations = argc > 2 ? (uint32)strtoul(argv[2], NULL, 10) : 200000;
+   uint32 maxBenchmarkObservers = argc > 3 ? (uint32)strtoul(argv[3], NULL, 10) : 1000000;
+   maxLive = argc > 4 ? (uint32)strtoul(argv[4], NULL, 10) : 1000;
+
+   RunBenchmark(maxBenchmarkObservers);
+
+   randomState = seed == 0 ? 1 : seed;
+   RunFuzzer(operations);
+   cout << "Fuzz seed " << seed << ": " << operations << " operations, "
+        << notifies << " notifies (" << nestedNotifies << " nested), "
+        << callbacks << " callbacks, "
+        << deletedInNotify << " deleted / " << detachedInNotify << " detached / "
+        << attachedInNotify << " attached during Notify" << endl;
+
+   if(failures > 0)
+   {
+      cout << failures << " FAILURES (seed " << seed << ")" << endl;
+      return 1;
+   }
+   cout << "PASSED" << endl;
+   return 0;
+}
@@ -0,0 +1,453 @@
+/********************************************************************
+ * File   : SplineKernelsBenchmark.cpp
+ * Project: CppUnitTest
+ *
+ ********************************************************************
+ * Created on 10/18/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+/* A stand alone benchmark for SplineKernels.  It compares the way the
+ * line smoothers used to tessellate a segment (one t at a time, through
+ * point temporaries, pushing each point onto a vector of structs) with
+ * the batch kernels writing straight into preallocated arrays.  It only
+ * needs SplineKernels.cpp (no cocos2d, no CppUnit):
+ *
+ *    g++ -std=gnu++98 -O2 -IToolsDemo CppUnitTest/SplineKernelsBenchmark.cpp ToolsDemo/SplineKernels.cpp -o spline_bench
+ *    ./spline_bench [segments] [passes]
+ *
+ * Add -DSPLINE_KERNELS_SCALAR to time a build without SSE2/NEON.  It is
+ * NOT part of the CppUnitTest target (it has its own main).
+ *
+ * Each pass tessellates a random stroke of segments (default 10000)
+ * with Catmull-Rom and with Hermite, the way LineSmootherCatmullRom and
+ * LineSmootherCardinal do, and reports ns per generated point for:
+ *
+ *    per point     - the old code (push_back of one SMOOTHED_POINT per t).
+ *    Scalar/SSE2.. - the kernels writing into arrays sized in advance.
+ *    ...+Extend    - the kernels plus growing the arrays one segment at
+ *                    a time (SMOOTHED_POINT_ARRAYS::Extend), which is
+ *                    what the line smoothers actually do.
+ *    forward diff  - SplineKernels::EvaluateForwardDifference (used by
+ *                    LineSmoother::TM_ADAPTIVE) at the same tick counts.
+ *
+ * It also prints how many points the adaptive (flatness based) step
+ * count would produce for the Catmull-Rom stroke.
+ *
+ * The outputs of all the paths are compared, and it fails if they
+ * differ by more than a small fraction of a pixel.
+ */
+
+#include "SplineKernels.h"
+#include <cstdlib>
+#include <cmath>
+#include <iomanip>
+#ifdef __APPLE__
+#include <mach/mach_time.h>
+#else
+#include <time.h>
+#endif
+
+static uint64 NowNanoseconds()
+{
+#ifdef __APPLE__
+   static mach_timebase_info_data_t timeBaseInfo;
+   if(timeBaseInfo.denom == 0)
+   {
+      mach_timebase_info(&timeBaseInfo);
+   }
+   return mach_absolute_time() * timeBaseInfo.numer / timeBaseInfo.denom;
+#else
+   struct timespec now;
+   clock_gettime(CLOCK_MONOTONIC, &now);
+   return (uint64)now.tv_sec*1000000000ULL + now.tv_nsec;
+#endif
+}
+
+// xorshift, so every platform gets the same stroke.
+static uint64 randomState = 1;
+
+static float RandomFloat()
+{
+   randomState ^= randomState << 13;
+   randomState ^= randomState >> 7;
+   randomState ^= randomState << 17;
+   return (randomState % 10000)/10000.0f;
+}
+
+// Stands in for CCPoint/ccpMult so the old path makes the same
+// temporaries it did in the smoothers.
+struct POINT
+{
+   float x;
+   float y;
+   POINT() : x(0), y(0) {}
+   POINT(float x_, float y_) : x(x_), y(y_) {}
+};
+
+static inline POINT Mult(const POINT& pt, float s)
+{
+   return POINT(pt.x*s, pt.y*s);
+}
+
+// The old SMOOTHED_POINT layout.
+struct SMOOTHED_POINT
+{
+   POINT point;
+   int position;
+   float widthPixels;
+};
+
+// The current SMOOTHED_POINT_ARRAYS layout.
+struct SMOOTHED_ARRAYS
+{
+   vector<float> x;
+   vector<float> y;
+   vector<float> widthPixels;
+   vector<uint8> position;
+   
+   void clear()
+   {
+      x.clear();
+      y.clear();
+      widthPixels.clear();
+      position.clear();
+   }
+   uint32 Extend(uint32 count)
+   {
+      uint32 first = x.size();
+      x.resize(first+count);
+      y.resize(first+count);
+      widthPixels.resize(first+count);
+      position.resize(first+count, 1);
+      return first;
+   }
+};
+
+typedef struct
+{
+   vector<POINT> points;
+   vector<POINT> tangents;
+   vector<float> widths;
+   vector<uint32> ticks;
+   uint32 totalPoints;
+} STROKE_T;
+
+static void MakeStroke(uint32 segments, STROKE_T& stroke)
+{
+   // A wandering stroke with 2..40 pixels between samples, which gives
+   // roughly the mix of tick counts a finger produces.
+   POINT pt(512, 384);
+   float heading = 0;
+   stroke.totalPoints = 0;
+   for(uint32 idx = 0; idx < segments + 3; idx++)
+   {
+      heading += (RandomFloat() - 0.5f);
+      float step = 2 + 38*RandomFloat();
+      pt = POINT(pt.x + step*cosf(heading), pt.y + step*sinf(heading));
+      stroke.points.push_back(pt);
+      stroke.widths.push_back(1 + 10*RandomFloat());
+   }
+   for(uint32 idx = 0; idx < stroke.points.size(); idx++)
+   {
+      uint32 prev = idx > 0 ? idx-1 : idx;
+      uint32 next = idx+1 < stroke.points.size() ? idx+1 : idx;
+      stroke.tangents.push_back(POINT((stroke.points[next].x - stroke.points[prev].x)*0.5f,
+                                      (stroke.points[next].y - stroke.points[prev].y)*0.5f));
+   }
+   for(uint32 idx = 0; idx < segments; idx++)
+   {
+      const POINT& p1 = stroke.points[idx+1];
+      const POINT& p2 = stroke.points[idx+2];
+      float dist = sqrtf((p2.x-p1.x)*(p2.x-p1.x) + (p2.y-p1.y)*(p2.y-p1.y));
+      uint32 ticks = (uint32)std::max(4.0f, dist/2.0f);
+      stroke.ticks.push_back(ticks);
+      stroke.totalPoints += ticks;
+   }
+}
+
+/**************************************************************
+ * Catmull-Rom
+ **************************************************************/
+
+static void CatmullRomPerPoint(const STROKE_T& stroke, vector<SMOOTHED_POINT>& out)
+{
+   out.clear();
+   for(uint32 seg = 0; seg < stroke.ticks.size(); seg++)
+   {
+      const POINT& p0 = stroke.points[seg];
+      const POINT& p1 = stroke.points[seg+1];
+      const POINT& p2 = stroke.points[seg+2];
+      const POINT& p3 = stroke.points[seg+3];
+      int ticks = stroke.ticks[seg];
+      double dt = 1.0/ticks;
+      for(int idx = 0; idx < ticks; idx++)
+      {
+         float time = idx*dt;
+         float tSq = time*time;
+         float tCube = tSq*time;
+         
+         POINT r0 = Mult(p0, 2*tSq - tCube - time);
+         POINT r1 = Mult(p1, 3*tCube - 5*tSq + 2);
+         POINT r2 = Mult(p2, 4*tSq - 3*tCube + time);
+         POINT r3 = Mult(p3, tCube - tSq);
+         
+         SMOOTHED_POINT sp;
+         sp.point = Mult(POINT(r0.x+r1.x+r2.x+r3.x, r0.y+r1.y+r2.y+r3.y), 0.5f);
+         sp.position = 1;
+         sp.widthPixels = stroke.widths[seg+1] + time*(stroke.widths[seg+2]-stroke.widths[seg+1]);
+         out.push_back(sp);
+      }
+   }
+}
+
+typedef void (*EVALUATE_T)(const SplineKernels::CUBIC_T& cubicX, const SplineKernels::CUBIC_T& cubicY, const SplineKernels::CUBIC_T& cubicWidth,
+                           float dt, uint32 count,
+                           float* outX, float* outY, float* outWidth);
+
+static void CatmullRomBatch(const STROKE_T& stroke, SMOOTHED_ARRAYS& out, EVALUATE_T evaluate, bool grow)
+{
+   if(grow)
+   {
+      out.clear();
+   }
+   uint32 first = 0;
+   for(uint32 seg = 0; seg < stroke.ticks.size(); seg++)
+   {
+      const POINT& p0 = stroke.points[seg];
+      const POINT& p1 = stroke.points[seg+1];
+      const POINT& p2 = stroke.points[seg+2];
+      const POINT& p3 = stroke.points[seg+3];
+      uint32 ticks = stroke.ticks[seg];
+      float dt = 1.0f/ticks;
+      if(grow)
+      {
+         first = out.Extend(ticks);
+      }
+      evaluate(SplineKernels::CatmullRomCubic(p0.x, p1.x, p2.x, p3.x),
+               SplineKernels::CatmullRomCubic(p0.y, p1.y, p2.y, p3.y),
+               SplineKernels::LinearCubic(stroke.widths[seg+1], stroke.widths[seg+2]),
+               dt, ticks,
+               &out.x[first], &out.y[first], &out.widthPixels[first]);
+      first += ticks;
+   }
+}
+
+/**************************************************************
+ * Hermite
+ **************************************************************/
+
+static POINT HermiteSpline(float t, POINT p0, POINT p1, POINT m0, POINT m1)
+{
+   float tSq = t*t;
+   float tCube = t*t*t;
+   POINT b0 = Mult(p0, 2*tCube - 3*tSq + 1);
+   POINT b1 = Mult(m0, tCube - 2*tSq + t);
+   POINT b2 = Mult(p1, 3*tSq - 2*tCube);
+   POINT b3 = Mult(m1, tCube - tSq);
+   return POINT(b0.x+b1.x+b2.x+b3.x, b0.y+b1.y+b2.y+b3.y);
+}
+
+static void HermitePerPoint(const STROKE_T& stroke, vector<SMOOTHED_POINT>& out)
+{
+   out.clear();
+   for(uint32 seg = 0; seg < stroke.ticks.size(); seg++)
+   {
+      int ticks = stroke.ticks[seg];
+      double dt = 1.0/ticks;
+      for(int idx = 0; idx < ticks; idx++)
+      {
+         float time = idx*dt;
+         SMOOTHED_POINT sp;
+         sp.point = HermiteSpline(time, stroke.points[seg+1], stroke.points[seg+2], stroke.tangents[seg+1], stroke.tangents[seg+2]);
+         sp.position = 1;
+         sp.widthPixels = stroke.widths[seg+1] + time*(stroke.widths[seg+2]-stroke.widths[seg+1]);
+         out.push_back(sp);
+      }
+   }
+}
+
+static void HermiteBatch(const STROKE_T& stroke, SMOOTHED_ARRAYS& out, EVALUATE_T evaluate, bool grow)
+{
+   if(grow)
+   {
+      out.clear();
+   }
+   uint32 first = 0;
+   for(uint32 seg = 0; seg < stroke.ticks.size(); seg++)
+   {
+      const POINT& p0 = stroke.points[seg+1];
+      const POINT& p1 = stroke.points[seg+2];
+      const POINT& m0 = stroke.tangents[seg+1];
+      const POINT& m1 = stroke.tangents[seg+2];
+      uint32 ticks = stroke.ticks[seg];
+      float dt = 1.0f/ticks;
+      if(grow)
+      {
+         first = out.Extend(ticks);
+      }
+      evaluate(SplineKernels::HermiteCubic(p0.x, p1.x, m0.x, m1.x),
+               SplineKernels::HermiteCubic(p0.y, p1.y, m0.y, m1.y),
+               SplineKernels::LinearCubic(stroke.widths[seg+1], stroke.widths[seg+2]),
+               dt, ticks,
+               &out.x[first], &out.y[first], &out.widthPixels[first]);
+      first += ticks;
+   }
+}
+
+/**************************************************************
+ * Driver
+ **************************************************************/
+
+static uint32 failures = 0;
+
+// The batch kernels compute t in float and use a different (but
+// equivalent) form of the cubic, so allow a little rounding.
+static const float MAX_ERROR_PIXELS = 0.01f;
+
+static float MaxDifference(const vector<SMOOTHED_POINT>& perPoint, const SMOOTHED_ARRAYS& batch)
+{
+   if(perPoint.size() != batch.x.size())
+   {
+      return 1.0e30f;
+   }
+   float result = 0;
+   for(uint32 idx = 0; idx < perPoint.size(); idx++)
+   {
+      result = std::max(result, fabsf(perPoint[idx].point.x - batch.x[idx]));
+      result = std::max(result, fabsf(perPoint[idx].point.y - batch.y[idx]));
+      result = std::max(result, fabsf(perPoint[idx].widthPixels - batch.widthPixels[idx]));
+   }
+   return result;
+}
+
+static void Report(const char* name, uint64 nanoseconds, uint32 passes, uint32 points, float maxError)
+{
+   cout << setw(28) << name
+        << setw(12) << fixed << setprecision(2) << (double)nanoseconds/passes/points
+        << setw(14) << setprecision(2) << nanoseconds/1000000.0/passes
+        << setw(14) << scientific << setprecision(2) << maxError
+        << endl;
+   if(maxError > MAX_ERROR_PIXELS)
+   {
+      cout << "FAILED: " << name << " differs from the per point path by " << maxError << " pixels" << endl;
+      failures++;
+   }
+}
+
+typedef void (*PER_POINT_T)(const STROKE_T& stroke, vector<SMOOTHED_POINT>& out);
+typedef void (*BATCH_T)(const STROKE_T& stroke, SMOOTHED_ARRAYS& out, EVALUATE_T evaluate, bool grow);
+
+static uint64 TimeBatch(const STROKE_T& stroke, uint32 passes, BATCH_T batch, SMOOTHED_ARRAYS& out, EVALUATE_T evaluate, bool grow)
+{
+   uint64 start = NowNanoseconds();
+   for(uint32 pass = 0; pass < passes; pass++)
+   {
+      batch(stroke, out, evaluate, grow);
+   }
+   return NowNanoseconds() - start;
+}
+
+static void Compare(const char* spline, const STROKE_T& stroke, uint32 passes, PER_POINT_T perPoint, BATCH_T batch)
+{
+   vector<SMOOTHED_POINT> perPointOut;
+   SMOOTHED_ARRAYS scalarOut;
+   SMOOTHED_ARRAYS simdOut;
+   SMOOTHED_ARRAYS growOut;
+   SMOOTHED_ARRAYS forwardOut;
+   
+   // One untimed pass each to size the outputs, the same as a line
+   // smoother that has already drawn a stroke.
+   perPoint(stroke, perPointOut);
+   batch(stroke, scalarOut, SplineKernels::EvaluateScalar, true);
+   batch(stroke, simdOut, SplineKernels::Evaluate, true);
+   batch(stroke, growOut, SplineKernels::Evaluate, true);
+   batch(stroke, forwardOut, SplineKernels::EvaluateForwardDifference, true);
+   
+   uint64 start = NowNanoseconds();
+   for(uint32 pass = 0; pass < passes; pass++)
+   {
+      perPoint(stroke, perPointOut);
+   }
+   uint64 perPointNs = NowNanoseconds() - start;
+   uint64 scalarNs = TimeBatch(stroke, passes, batch, scalarOut, SplineKernels::EvaluateScalar, false);
+   uint64 simdNs = TimeBatch(stroke, passes, batch, simdOut, SplineKernels::Evaluate, false);
+   uint64 growNs = TimeBatch(stroke, passes, batch, growOut, SplineKernels::Evaluate, true);
+   uint64 forwardNs = TimeBatch(stroke, passes, batch, forwardOut, SplineKernels::EvaluateForwardDifference, false);
+   
+   string name(spline);
+   string kernel(SplineKernels::GetKernelName());
+   Report((name + " per point").c_str(), perPointNs, passes, stroke.totalPoints, 0);
+   Report((name + " Scalar").c_str(), scalarNs, passes, stroke.totalPoints, MaxDifference(perPointOut, scalarOut));
+   Report((name + " " + kernel).c_str(), simdNs, passes, stroke.totalPoints, MaxDifference(perPointOut, simdOut));
+   Report((name + " " + kernel + "+Extend").c_str(), growNs, passes, stroke.totalPoints, MaxDifference(perPointOut, growOut));
+   Report((name + " forward diff").c_str(), forwardNs, passes, stroke.totalPoints, MaxDifference(perPointOut, forwardOut));
+   cout << setw(28) << "speedup" << setw(12) << fixed << setprecision(2) << (double)perPointNs/simdNs << "x"
+        << " (" << (double)perPointNs/growNs << "x with Extend)" << endl;
+}
+
+int main(int argc, const char* argv[])
+{
+   uint32 segments = argc > 1 ? (uint32)strtoul(argv[1], NULL, 10) : 10000;
+   uint32 passes = argc > 2 ? (uint32)strtoul(argv[2], NULL, 10) : 100;
+   if(segments == 0 || passes == 0)
+   {
+      cout << "Usage: " << argv[0] << " [segments] [passes]" << endl;
+      return 1;
+   }
+   
+   STROKE_T stroke;
+   MakeStroke(segments, stroke);
+   cout << "Stroke: " << segments << " segments, " << stroke.totalPoints << " points, "
+        << passes << " passes, kernel " << SplineKernels::GetKernelName() << endl;
+   cout << setw(28) << "Path" << setw(12) << "ns/point" << setw(14) << "ms/stroke" << setw(14) << "max error" << endl;
+   
+   Compare("Catmull-Rom", stroke, passes, CatmullRomPerPoint, CatmullRomBatch);
+   Compare("Hermite", stroke, passes, HermitePerPoint, HermiteBatch);
+   
+   // How many points LineSmoother::TM_ADAPTIVE would emit for the same
+   // stroke (it never uses more than the uniform tick count).
+   const float tolerances[] = { 0.1f, 0.25f, 0.5f, 1.0f };
+   for(uint32 idx = 0; idx < sizeof(tolerances)/sizeof(tolerances[0]); idx++)
+   {
+      uint32 adaptivePoints = 0;
+      for(uint32 seg = 0; seg < stroke.ticks.size(); seg++)
+      {
+         const POINT& p0 = stroke.points[seg];
+         const POINT& p1 = stroke.points[seg+1];
+         const POINT& p2 = stroke.points[seg+2];
+         const POINT& p3 = stroke.points[seg+3];
+         uint32 steps = SplineKernels::FlatnessSteps(SplineKernels::CatmullRomCubic(p0.x, p1.x, p2.x, p3.x),
+                                                     SplineKernels::CatmullRomCubic(p0.y, p1.y, p2.y, p3.y),
+                                                     tolerances[idx]);
+         adaptivePoints += std::min(steps, stroke.ticks[seg]);
+      }
+      cout << "Catmull-Rom adaptive, flatness " << fixed << setprecision(2) << tolerances[idx] << "px: "
+           << adaptivePoints << " points (" << setprecision(1) << 100.0*adaptivePoints/stroke.totalPoints << "% of uniform)" << endl;
+   }
+   
+   if(failures > 0)
+   {
+      cout << failures << " FAILURES" << endl;
+      return 1;
+   }
+   cout << "PASSED" << endl;
+   return 0;
+}
@@ -0,0 +1,236 @@
+/********************************************************************
+ * File   : TestLineSimplifier.cpp
+ * Project: CppUnitTest
+ *
+ ********************************************************************
+ * Created on 10/20/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+#include "TestLineSimplifier.h"
+#include "LineSimplifier.h"
+#include "LineSmootherCatmullRom.h"
+#include <cstdlib>
+#include <cmath>
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TestLineSimplifier);
+
+// The distance from (px,py) to the segment (ax,ay)-(bx,by), worked out
+// independently of LineSimplifier.
+static double DistanceToSegment(double px, double py, double ax, double ay, double bx, double by)
+{
+   double dx = bx - ax;
+   double dy = by - ay;
+   double lengthSq = dx*dx + dy*dy;
+   double t = 0;
+   if(lengthSq > 0)
+   {
+      t = ((px - ax)*dx + (py - ay)*dy)/lengthSq;
+      t = t < 0 ? 0 : t > 1 ? 1 : t;
+   }
+   double ex = ax + t*dx - px;
+   double ey = ay + t*dy - py;
+   return sqrt(ex*ex + ey*ey);
+}
+
+TestLineSimplifier::TestLineSimplifier()
+{
+   
+}
+
+TestLineSimplifier::~TestLineSimplifier()
+{
+   
+}
+
+void TestLineSimplifier::setUp()
+{
+   
+}
+
+void TestLineSimplifier::tearDown()
+{
+   
+}
+
+// Verify the radial distance filter drops points within the
+// tolerance of the last kept point, and keeps the rest.
+void TestLineSimplifier::TestRadialDistanceFilter()
+{
+   RadialDistanceFilter filter(2.0f);
+   
+   CPPUNIT_ASSERT(filter.GetTolerancePixels() == 2.0f);
+   filter.LineBegin(ccp(0,0), 0.0);
+   CPPUNIT_ASSERT(!filter.Accept(ccp(1,0), 0.1));
+   // Exactly on the tolerance is still too close.
+   CPPUNIT_ASSERT(!filter.Accept(ccp(2,0), 0.2));
+   CPPUNIT_ASSERT(filter.Accept(ccp(2.5f,0), 0.3));
+   // Now measured from the point just kept.
+   CPPUNIT_ASSERT(!filter.Accept(ccp(4,0), 0.4));
+   CPPUNIT_ASSERT(filter.Accept(ccp(2.5f,2.5f), 0.5));
+   // A new stroke starts over.
+   filter.LineBegin(ccp(100,100), 1.0);
+   CPPUNIT_ASSERT(!filter.Accept(ccp(101,101), 1.1));
+   CPPUNIT_ASSERT(filter.Accept(ccp(2.5f,2.5f), 1.2));
+   
+   // Zero keeps everything that moved at all.
+   filter.SetTolerancePixels(0.0f);
+   filter.LineBegin(ccp(0,0), 0.0);
+   CPPUNIT_ASSERT(!filter.Accept(ccp(0,0), 0.1));
+   CPPUNIT_ASSERT(filter.Accept(ccp(0.01f,0), 0.2));
+   
+   CPPUNIT_ASSERT_THROW(filter.SetTolerancePixels(-1.0f), std::out_of_range);
+}
+
+// Verify a LineSmoother with a point filter only smooths the points
+// it keeps, but always keeps the first and last.
+void TestLineSimplifier::TestPointFilterInSmoother()
+{
+   LineSmootherCatmullRom smoother;
+   smoother.SetPointFilter(new RadialDistanceFilter(3.0f));
+   
+   // Ten points a pixel apart, then a big jump, then the end right
+   // next to it.
+   smoother.LineBegin(ccp(0,0), 0.0);
+   for(uint32 idx = 1; idx < 10; idx++)
+   {
+      smoother.LineContinue(ccp(idx,0), idx*0.01);
+   }
+   smoother.LineContinue(ccp(50,0), 0.10);
+   smoother.LineEnd(ccp(50.5f,0), 0.11);
+   
+   // Kept: 0, 4, 8, 50 and the end.
+   const LineSmoother::ORIGINAL_POINT_ARRAYS& original = smoother.GetOriginalPointsConst();
+   CPPUNIT_ASSERT(original.size() == 5);
+   CPPUNIT_ASSERT(original.x[0] == 0.0f);
+   CPPUNIT_ASSERT(original.x[1] == 4.0f);
+   CPPUNIT_ASSERT(original.x[2] == 8.0f);
+   CPPUNIT_ASSERT(original.x[3] == 50.0f);
+   CPPUNIT_ASSERT(original.x[4] == 50.5f);
+   // Kept points keep their own timestamps.
+   CPPUNIT_ASSERT(original.timestamp[1] == 0.04);
+   CPPUNIT_ASSERT(original.position.back() == LineSmoother::LP_END);
+   
+   // Taking the filter off keeps everything again.
+   smoother.SetPointFilter(NULL);
+   smoother.LineBegin(ccp(0,0), 0.0);
+   smoother.LineContinue(ccp(1,0), 0.01);
+   smoother.LineEnd(ccp(2,0), 0.02);
+   CPPUNIT_ASSERT(smoother.GetOriginalPointsConst().size() == 3);
+}
+
+// Verify Ramer-Douglas-Peucker keeps the corners of simple shapes
+// and handles strokes too short to simplify.
+void TestLineSimplifier::TestRamerDouglasPeuckerShapes()
+{
+   vector<uint8> keep;
+   
+   // Nothing, one point and two points.
+   float32 x[7];
+   float32 y[7];
+   CPPUNIT_ASSERT(LineSimplifier::RamerDouglasPeucker(x, y, 0, 1.0f, keep) == 0);
+   CPPUNIT_ASSERT(keep.empty());
+   x[0] = 0; y[0] = 0;
+   x[1] = 5; y[1] = 5;
+   CPPUNIT_ASSERT(LineSimplifier::RamerDouglasPeucker(x, y, 1, 1.0f, keep) == 1);
+   CPPUNIT_ASSERT(keep.size() == 1 && keep[0] == 1);
+   CPPUNIT_ASSERT(LineSimplifier::RamerDouglasPeucker(x, y, 2, 1.0f, keep) == 2);
+   CPPUNIT_ASSERT(keep.size() == 2 && keep[0] == 1 && keep[1] == 1);
+   
+   // A straight line keeps just the ends.
+   for(uint32 idx = 0; idx < 7; idx++)
+   {
+      x[idx] = idx;
+      y[idx] = 2*idx;
+   }
+   CPPUNIT_ASSERT(LineSimplifier::RamerDouglasPeucker(x, y, 7, 0.5f, keep) == 2);
+   CPPUNIT_ASSERT(keep[0] == 1 && keep[6] == 1);
+   for(uint32 idx = 1; idx < 6; idx++)
+   {
+      CPPUNIT_ASSERT(keep[idx] == 0);
+   }
+   
+   // A right angle keeps the ends and the corner.
+   const float32 cornerX[7] = { 0, 1, 2, 3, 3, 3, 3 };
+   const float32 cornerY[7] = { 0, 0, 0, 0, 1, 2, 3 };
+   CPPUNIT_ASSERT(LineSimplifier::RamerDouglasPeucker(cornerX, cornerY, 7, 0.5f, keep) == 3);
+   CPPUNIT_ASSERT(keep[0] == 1 && keep[3] == 1 && keep[6] == 1);
+   
+   // A bump smaller than the tolerance goes, a bigger one stays.
+   const float32 bumpX[5] = { 0, 1, 2, 3, 4 };
+   const float32 bumpY[5] = { 0, 0, 0.4f, 0, 0 };
+   CPPUNIT_ASSERT(LineSimplifier::RamerDouglasPeucker(bumpX, bumpY, 5, 0.5f, keep) == 2);
+   CPPUNIT_ASSERT(LineSimplifier::RamerDouglasPeucker(bumpX, bumpY, 5, 0.3f, keep) == 3);
+   CPPUNIT_ASSERT(keep[2] == 1);
+   
+   // A closed loop (the ends are the same point).
+   const float32 loopX[5] = { 0, 10, 10, 0, 0 };
+   const float32 loopY[5] = { 0, 0, 10, 10, 0 };
+   CPPUNIT_ASSERT(LineSimplifier::RamerDouglasPeucker(loopX, loopY, 5, 1.0f, keep) == 5);
+}
+
+// Verify every point Ramer-Douglas-Peucker drops is within the
+// tolerance of the simplified line.
+void TestLineSimplifier::TestRamerDouglasPeuckerTolerance()
+{
+   const uint32 POINTS = 5000;
+   const float TOLERANCES[] = { 0.25f, 1.0f, 4.0f };
+   vector<float32> x(POINTS);
+   vector<float32> y(POINTS);
+   vector<uint8> keep;
+   
+   srand(1234);
+   // A random walk, so there are wiggles of every size.
+   x[0] = 0;
+   y[0] = 0;
+   for(uint32 idx = 1; idx < POINTS; idx++)
+   {
+      x[idx] = x[idx-1] + (rand()%2001 - 1000)/500.0f;
+      y[idx] = y[idx-1] + (rand()%2001 - 1000)/500.0f;
+   }
+   for(uint32 tolIdx = 0; tolIdx < sizeof(TOLERANCES)/sizeof(TOLERANCES[0]); tolIdx++)
+   {
+      float tolerance = TOLERANCES[tolIdx];
+      uint32 kept = LineSimplifier::RamerDouglasPeucker(&x[0], &y[0], POINTS, tolerance, keep);
+      CPPUNIT_ASSERT(keep.size() == POINTS);
+      CPPUNIT_ASSERT(keep[0] == 1 && keep[POINTS-1] == 1);
+      CPPUNIT_ASSERT(kept > 2 && kept < POINTS);
+      
+      uint32 counted = 1;
+      uint32 lastKept = 0;
+      for(uint32 idx = 1; idx < POINTS; idx++)
+      {
+         if(!keep[idx])
+         {
+            continue;
+         }
+         counted++;
+         for(uint32 dropped = lastKept+1; dropped < idx; dropped++)
+         {
+            double distance = DistanceToSegment(x[dropped], y[dropped],
+                                                x[lastKept], y[lastKept],
+                                                x[idx], y[idx]);
+            CPPUNIT_ASSERT(distance <= tolerance + 1.0e-4);
+         }
+         lastKept = idx;
+      }
+      CPPUNIT_ASSERT(counted == kept);
+   }
+}
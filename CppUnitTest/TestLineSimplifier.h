@@ -0,0 +1,70 @@
+/********************************************************************
+ * File   : TestLineSimplifier.h
+ * Project: CppUnitTest
+ *
+ ********************************************************************
+ * Created on 10/20/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+#ifndef __CppUnitTest__TestLineSimplifier__
+#define __CppUnitTest__TestLineSimplifier__
+
+#include <cppunit/TestCase.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+
+/* Executes unit tests against the "LineSimplifier" and
+ * "RadialDistanceFilter" classes.
+ */
+class TestLineSimplifier : public CppUnit::TestFixture
+{
+   
+public:
+   TestLineSimplifier();
+   ~TestLineSimplifier();
+   
+   // Verify the radial distance filter drops points within the
+   // tolerance of the last kept point, and keeps the rest.
+   void TestRadialDistanceFilter();
+   // Verify a LineSmoother with a point filter only smooths the points
+   // it keeps, but always keeps the first and last.
+   void TestPointFilterInSmoother();
+   // Verify Ramer-Douglas-Peucker keeps the corners of simple shapes
+   // and handles strokes too short to simplify.
+   void TestRamerDouglasPeuckerShapes();
+   // Verify every point Ramer-Douglas-Peucker drops is within the
+   // tolerance of the simplified line.
+   void TestRamerDouglasPeuckerTolerance();
+   
+   void setUp();
+   void tearDown();
+   
+public:
+   CPPUNIT_TEST_SUITE(TestLineSimplifier);
+   CPPUNIT_TEST(TestRadialDistanceFilter);
+   CPPUNIT_TEST(TestPointFilterInSmoother);
+   CPPUNIT_TEST(TestRamerDouglasPeuckerShapes);
+   CPPUNIT_TEST(TestRamerDouglasPeuckerTolerance);
+   CPPUNIT_TEST_SUITE_END();
+   
+};
+
+#endif /* defined(__CppUnitTest__TestLineSimplifier__) */
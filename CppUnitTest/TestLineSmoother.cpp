@@ -0,0 +1,273 @@
+/********************************************************************
+ * File   : TestLineSmoother.cpp
+ * Project: CppUnitTest
+ *
+ ********************************************************************
+ * Created on 10/20/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+#include "TestLineSmoother.h"
+#include "LineSmootherCatmullRom.h"
+#include "LineSmootherCardinal.h"
+#include "LineSmootherCatmullRomAlpha.h"
+#include "LineSimplifier.h"
+#include "WorkerPool.h"
+#include <cstring>
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TestLineSmoother);
+
+/* Every kind of smoother in every mode, so each test can run them all.
+ */
+typedef enum
+{
+   SK_CATMULL_ROM = 0,
+   SK_CARDINAL,
+   SK_CENTRIPETAL,
+   SK_CHORDAL,
+   SK_MAX
+} SMOOTHER_KIND_T;
+
+static LineSmoother* CreateSmoother(uint32 config)
+{
+   LineSmoother* smoother = NULL;
+   switch((SMOOTHER_KIND_T)(config % SK_MAX))
+   {
+      case SK_CATMULL_ROM:
+         smoother = new LineSmootherCatmullRom();
+         break;
+      case SK_CARDINAL:
+         smoother = new LineSmootherCardinal();
+         break;
+      case SK_CENTRIPETAL:
+         smoother = new LineSmootherCentripetal();
+         break;
+      case SK_CHORDAL:
+         smoother = new LineSmootherChordal();
+         break;
+      default:
+         assert(false);
+         break;
+   }
+   config /= SK_MAX;
+   smoother->SetTessellationMode((config & 1) ? LineSmoother::TM_ADAPTIVE : LineSmoother::TM_UNIFORM);
+   smoother->SetVelocityFilter((config & 2) ? LineSmoother::VF_ONE_EURO : LineSmoother::VF_BOX);
+   return smoother;
+}
+
+static const uint32 SMOOTHER_CONFIGS = SK_MAX*4;
+
+/* A wobbly stroke with slightly uneven timestamps, like a real touch.
+ */
+static void MakeStroke(uint32 count, vector<CCPoint>& points, vector<double>& timestamps)
+{
+   points.clear();
+   timestamps.clear();
+   for(uint32 idx = 0; idx < count; idx++)
+   {
+      points.push_back(ccp(100 + 300*sinf(idx*0.05f), 200 + 150*cosf(idx*0.065f) + 0.5f*(idx%5)));
+      timestamps.push_back(idx*0.016 + (idx%3)*0.002);
+   }
+}
+
+template <typename T>
+static bool SameBytes(const vector<T>& left, const vector<T>& right)
+{
+   return left.size() == right.size() &&
+   (left.empty() || memcmp(&left[0], &right[0], left.size()*sizeof(T)) == 0);
+}
+
+static bool SameSmoothedPoints(const LineSmoother::SMOOTHED_POINT_ARRAYS& left,
+                               const LineSmoother::SMOOTHED_POINT_ARRAYS& right)
+{
+   return SameBytes(left.x, right.x) &&
+   SameBytes(left.y, right.y) &&
+   SameBytes(left.widthPixels, right.widthPixels) &&
+   SameBytes(left.position, right.position);
+}
+
+static const uint32 STROKE_SIZES[] = { 1, 2, 3, 4, 5, 9, 1000, 20000 };
+static const uint32 STROKE_SIZE_COUNT = sizeof(STROKE_SIZES)/sizeof(STROKE_SIZES[0]);
+
+TestLineSmoother::TestLineSmoother()
+{
+   
+}
+
+TestLineSmoother::~TestLineSmoother()
+{
+   
+}
+
+void TestLineSmoother::setUp()
+{
+   
+}
+
+void TestLineSmoother::tearDown()
+{
+   
+}
+
+// Verify SmoothAll(...) gives the same smoothed points as feeding the
+// stroke through LineBegin/LineContinue/LineEnd.
+void TestLineSmoother::TestSmoothAllMatchesIncremental()
+{
+   vector<CCPoint> points;
+   vector<double> timestamps;
+   
+   for(uint32 sizeIdx = 0; sizeIdx < STROKE_SIZE_COUNT; sizeIdx++)
+   {
+      MakeStroke(STROKE_SIZES[sizeIdx], points, timestamps);
+      for(uint32 config = 0; config < SMOOTHER_CONFIGS; config++)
+      {
+         LineSmoother* incremental = CreateSmoother(config);
+         LineSmoother* batch = CreateSmoother(config);
+         
+         for(uint32 idx = 0; idx < points.size(); idx++)
+         {
+            if(idx == 0)
+               incremental->LineBegin(points[idx], timestamps[idx]);
+            else if(idx == points.size()-1)
+               incremental->LineEnd(points[idx], timestamps[idx]);
+            else
+               incremental->LineContinue(points[idx], timestamps[idx]);
+         }
+         LineSmoother::SMOOTHED_POINT_ARRAYS output;
+         batch->SmoothAll(&points[0], &timestamps[0], points.size(), output);
+         
+         CPPUNIT_ASSERT(SameSmoothedPoints(incremental->GetSmoothedPointsConst(), output));
+         delete incremental;
+         delete batch;
+      }
+   }
+}
+
+// Verify SmoothAll(...) on worker threads gives exactly the same
+// smoothed points as SmoothAll(...) on the caller alone.
+void TestLineSmoother::TestSmoothAllThreaded()
+{
+   vector<CCPoint> points;
+   vector<double> timestamps;
+   WorkerPool workers;
+   
+   // Straight after Init(...), so the workers may not have started yet.
+   workers.Init(3);
+   for(uint32 sizeIdx = 0; sizeIdx < STROKE_SIZE_COUNT; sizeIdx++)
+   {
+      MakeStroke(STROKE_SIZES[sizeIdx], points, timestamps);
+      for(uint32 config = 0; config < SMOOTHER_CONFIGS; config++)
+      {
+         LineSmoother* single = CreateSmoother(config);
+         LineSmoother* threaded = CreateSmoother(config);
+         
+         LineSmoother::SMOOTHED_POINT_ARRAYS singleOutput;
+         LineSmoother::SMOOTHED_POINT_ARRAYS threadedOutput;
+         single->SmoothAll(&points[0], &timestamps[0], points.size(), singleOutput);
+         threaded->SmoothAll(&points[0], &timestamps[0], points.size(), threadedOutput, &workers);
+         
+         CPPUNIT_ASSERT(points.size() < 3 || !singleOutput.empty());
+         CPPUNIT_ASSERT(SameSmoothedPoints(singleOutput, threadedOutput));
+         delete single;
+         delete threaded;
+      }
+   }
+   workers.Shutdown();
+}
+
+// Verify SmoothAll(...) with end simplification smooths just the
+// points Ramer-Douglas-Peucker keeps, and LineEnd(...) ignores it.
+void TestLineSmoother::TestEndSimplify()
+{
+   const float SIMPLIFY_PIXELS = 1.0f;
+   vector<CCPoint> points;
+   vector<double> timestamps;
+   
+   MakeStroke(1000, points, timestamps);
+   
+   // Simplify the stroke by hand.
+   vector<float32> x;
+   vector<float32> y;
+   for(uint32 idx = 0; idx < points.size(); idx++)
+   {
+      x.push_back(points[idx].x);
+      y.push_back(points[idx].y);
+   }
+   vector<uint8> keep;
+   uint32 kept = LineSimplifier::RamerDouglasPeucker(&x[0], &y[0], points.size(), SIMPLIFY_PIXELS, keep);
+   CPPUNIT_ASSERT(kept > 2 && kept < points.size());
+   vector<CCPoint> keptPoints;
+   vector<double> keptTimestamps;
+   for(uint32 idx = 0; idx < points.size(); idx++)
+   {
+      if(keep[idx])
+      {
+         keptPoints.push_back(points[idx]);
+         keptTimestamps.push_back(timestamps[idx]);
+      }
+   }
+   
+   for(uint32 config = 0; config < SMOOTHER_CONFIGS; config++)
+   {
+      LineSmoother* simplified = CreateSmoother(config);
+      LineSmoother* byHand = CreateSmoother(config);
+      
+      simplified->SetEndSimplifyPixels(SIMPLIFY_PIXELS);
+      LineSmoother::SMOOTHED_POINT_ARRAYS simplifiedOutput;
+      LineSmoother::SMOOTHED_POINT_ARRAYS byHandOutput;
+      simplified->SmoothAll(&points[0], &timestamps[0], points.size(), simplifiedOutput);
+      byHand->SmoothAll(&keptPoints[0], &keptTimestamps[0], keptPoints.size(), byHandOutput);
+      CPPUNIT_ASSERT(SameSmoothedPoints(simplifiedOutput, byHandOutput));
+      CPPUNIT_ASSERT(simplified->GetOriginalPointsConst().size() == kept);
+      
+      // Fed a point at a time, nothing already handed out changes.
+      LineSmoother* incremental = CreateSmoother(config);
+      incremental->SetEndSimplifyPixels(SIMPLIFY_PIXELS);
+      LineSmoother* plain = CreateSmoother(config);
+      for(uint32 idx = 0; idx < points.size(); idx++)
+      {
+         if(idx == 0)
+         {
+            incremental->LineBegin(points[idx], timestamps[idx]);
+            plain->LineBegin(points[idx], timestamps[idx]);
+         }
+         else if(idx == points.size()-1)
+         {
+            incremental->LineEnd(points[idx], timestamps[idx]);
+            plain->LineEnd(points[idx], timestamps[idx]);
+         }
+         else
+         {
+            incremental->LineContinue(points[idx], timestamps[idx]);
+            plain->LineContinue(points[idx], timestamps[idx]);
+         }
+         CPPUNIT_ASSERT(incremental->GetLastSmoothPointIndex() == plain->GetLastSmoothPointIndex());
+         incremental->MarkLastSmoothPointIndex();
+         plain->MarkLastSmoothPointIndex();
+      }
+      CPPUNIT_ASSERT(incremental->GetOriginalPointsConst().size() == points.size());
+      CPPUNIT_ASSERT(SameSmoothedPoints(incremental->GetSmoothedPointsConst(), plain->GetSmoothedPointsConst()));
+      
+      delete simplified;
+      delete byHand;
+      delete incremental;
+      delete plain;
+   }
+}
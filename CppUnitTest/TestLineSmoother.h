@@ -0,0 +1,65 @@
+/********************************************************************
+ * File   : TestLineSmoother.h
+ * Project: CppUnitTest
+ *
+ ********************************************************************
+ * Created on 10/20/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+#ifndef __CppUnitTest__TestLineSmoother__
+#define __CppUnitTest__TestLineSmoother__
+
+#include <cppunit/TestCase.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+
+/* Executes unit tests against the "LineSmoother" classes.
+ */
+class TestLineSmoother : public CppUnit::TestFixture
+{
+   
+public:
+   TestLineSmoother();
+   ~TestLineSmoother();
+   
+   // Verify SmoothAll(...) gives the same smoothed points as feeding the
+   // stroke through LineBegin/LineContinue/LineEnd.
+   void TestSmoothAllMatchesIncremental();
+   // Verify SmoothAll(...) on worker threads gives exactly the same
+   // smoothed points as SmoothAll(...) on the caller alone.
+   void TestSmoothAllThreaded();
+   // Verify SmoothAll(...) with end simplification smooths just the
+   // points Ramer-Douglas-Peucker keeps, and LineEnd(...) ignores it.
+   void TestEndSimplify();
+   
+   void setUp();
+   void tearDown();
+   
+public:
+   CPPUNIT_TEST_SUITE(TestLineSmoother);
+   CPPUNIT_TEST(TestSmoothAllMatchesIncremental);
+   CPPUNIT_TEST(TestSmoothAllThreaded);
+   CPPUNIT_TEST(TestEndSimplify);
+   CPPUNIT_TEST_SUITE_END();
+   
+};
+
+#endif /* defined(__CppUnitTest__TestLineSmoother__) */
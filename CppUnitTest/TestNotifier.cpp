@@ -26,9 +26,33 @@
 
 #include "TestNotifier.h"
 #include "Notifier.h"
+#include <pthread.h>
+#include <sched.h>
+#include <cstdlib>
+#include <ctime>
+#include <new>
 
 CPPUNIT_TEST_SUITE_REGISTRATION(TestNotifier);
 
+/* Count every allocation made by the program so we can verify
+ * that some operations don't allocate.
+ */
+static uint32 allocationCount = 0;
+
+void* operator new(size_t size) throw(std::bad_alloc)
+{
+   allocationCount++;
+   void* result = malloc(size == 0 ? 1 : size);
+   if(result == NULL)
+      throw std::bad_alloc();
+   return result;
+}
+
+void operator delete(void* ptr) throw()
+{
+   free(ptr);
+}
+
 /* We're going to need a class to receive notifications and give us some 
  * info about it when needed.
  */
@@ -75,6 +99,22 @@ public:
    }
 };
 
+/* This one keeps a copy of the payload (an int) for each notification 
+ * instead of the pointer, so we can check posted payloads.
+ */
+class PayloadTarget : public Notified
+{
+private:
+   vector<int32> _payloads;
+public:
+   const vector<int32>& GetPayloads() { return _payloads; }
+   
+   virtual void Notify(Notifier::NOTIFIED_EVENT_TYPE_T eventType, const void* eventData)
+   {
+      _payloads.push_back(eventData == NULL ? -1 : *((const int32*)eventData));
+   }
+};
+
 NotifyTarget* pNotifyTarget1;
 NotifyTarget* pNotifyTarget2;
 NotifyTarget* pNotifyTarget3;
@@ -126,6 +166,23 @@ static void DeleteNotifyTarget3()
    DeleteNotifyTarget(pNotifyTarget3);
 }
 
+static void DetachNotifyTarget3FromButton()
+{
+   Notifier::Instance().Detach(pNotifyTarget3, Notifier::NE_DEBUG_BUTTON_PRESSED);
+}
+
+static void AttachNotifyTarget2ToButton()
+{
+   Notifier::Instance().Attach(pNotifyTarget2, Notifier::NE_DEBUG_BUTTON_PRESSED);
+}
+
+#ifdef NOTIFIER_STATS
+static void NotifyResetDrawCycle()
+{
+   Notifier::Instance().Notify(Notifier::NE_RESET_DRAW_CYCLE);
+}
+#endif
+
 static void ResetNotifyTargets()
 {
    if(pNotifyTarget1 != NULL)
@@ -581,3 +638,737 @@ void TestNotifier::TestReset()
    }
 }
 
+
+// Verify Post(...) defers delivery until DispatchPending(...).
+void TestNotifier::TestPostDeferred()
+{
+   vector<NotifyTarget::NOTIFY_PAIR_T> pairs;
+   
+   RegisterTestObjects();
+   
+   CPPUNIT_ASSERT(Notifier::Instance().Post(Notifier::NE_DEBUG_BUTTON_PRESSED) == true);
+   CPPUNIT_ASSERT(Notifier::Instance().Post(Notifier::NE_RESET_DRAW_CYCLE) == true);
+   
+   // Nothing should have been delivered yet.
+   CPPUNIT_ASSERT(pNotifyTarget1->GetNotifications().size() == 0);
+   CPPUNIT_ASSERT(pNotifyTarget2->GetNotifications().size() == 0);
+   CPPUNIT_ASSERT(pNotifyTarget3->GetNotifications().size() == 0);
+   
+   CPPUNIT_ASSERT(Notifier::Instance().DispatchPending() == 2);
+   
+   pairs = pNotifyTarget1->GetNotifications();
+   CPPUNIT_ASSERT(pairs.size() == 1);
+   CPPUNIT_ASSERT(pairs[0].eventType == Notifier::NE_DEBUG_BUTTON_PRESSED);
+   CPPUNIT_ASSERT(pairs[0].eventData == NULL);
+   pairs = pNotifyTarget2->GetNotifications();
+   CPPUNIT_ASSERT(pairs.size() == 1);
+   CPPUNIT_ASSERT(pairs[0].eventType == Notifier::NE_RESET_DRAW_CYCLE);
+   pairs = pNotifyTarget3->GetNotifications();
+   CPPUNIT_ASSERT(pairs.size() == 2);
+   CPPUNIT_ASSERT(pairs[0].eventType == Notifier::NE_DEBUG_BUTTON_PRESSED);
+   CPPUNIT_ASSERT(pairs[1].eventType == Notifier::NE_RESET_DRAW_CYCLE);
+   
+   // The queue should be empty now.
+   CPPUNIT_ASSERT(Notifier::Instance().DispatchPending() == 0);
+   
+   // Bad arguments.
+   CPPUNIT_ASSERT_THROW(Notifier::Instance().Post(Notifier::NE_MAX), std::out_of_range);
+   CPPUNIT_ASSERT_THROW(Notifier::Instance().Post(Notifier::NE_MIN, NULL, 4), std::out_of_range);
+   CPPUNIT_ASSERT_THROW(Notifier::Instance().Post(Notifier::NE_MIN, pNotifyTarget1, Notifier::POST_PAYLOAD_SIZE_MAX+1), std::out_of_range);
+}
+
+// Verify a posted payload is copied and the budget is honored.
+void TestNotifier::TestPostPayloadAndBudget()
+{
+   PayloadTarget target;
+   
+   Notifier::Instance().Attach(&target, Notifier::NE_DEBUG_BUTTON_PRESSED);
+   
+   for(int32 idx = 0; idx < 10; idx++)
+   {
+      int32 value = idx;
+      CPPUNIT_ASSERT(Notifier::Instance().Post(Notifier::NE_DEBUG_BUTTON_PRESSED, &value, sizeof(value)) == true);
+      // Scribble on it...the queue should have its own copy.
+      value = -100;
+   }
+   
+   CPPUNIT_ASSERT(Notifier::Instance().DispatchPending(3) == 3);
+   CPPUNIT_ASSERT(target.GetPayloads().size() == 3);
+   CPPUNIT_ASSERT(Notifier::Instance().DispatchPending() == 7);
+   CPPUNIT_ASSERT(target.GetPayloads().size() == 10);
+   for(int32 idx = 0; idx < 10; idx++)
+   {
+      CPPUNIT_ASSERT(target.GetPayloads()[idx] == idx);
+   }
+}
+
+// Verify Post(...) fails cleanly when the queue is full.
+void TestNotifier::TestPostQueueFull()
+{
+   PayloadTarget target;
+   
+   Notifier::Instance().Attach(&target, Notifier::NE_DEBUG_BUTTON_PRESSED);
+   
+   for(int32 idx = 0; idx < Notifier::POST_QUEUE_SIZE; idx++)
+   {
+      CPPUNIT_ASSERT(Notifier::Instance().Post(Notifier::NE_DEBUG_BUTTON_PRESSED, &idx, sizeof(idx)) == true);
+   }
+   int32 value = Notifier::POST_QUEUE_SIZE;
+   CPPUNIT_ASSERT(Notifier::Instance().Post(Notifier::NE_DEBUG_BUTTON_PRESSED, &value, sizeof(value)) == false);
+   
+   // Drain part of it and verify we can post again.
+   CPPUNIT_ASSERT(Notifier::Instance().DispatchPending(1) == 1);
+   CPPUNIT_ASSERT(Notifier::Instance().Post(Notifier::NE_DEBUG_BUTTON_PRESSED, &value, sizeof(value)) == true);
+   CPPUNIT_ASSERT(Notifier::Instance().DispatchPending() == Notifier::POST_QUEUE_SIZE);
+   
+   // Everything should have come out in order.
+   CPPUNIT_ASSERT(target.GetPayloads().size() == Notifier::POST_QUEUE_SIZE+1);
+   for(int32 idx = 0; idx <= Notifier::POST_QUEUE_SIZE; idx++)
+   {
+      CPPUNIT_ASSERT(target.GetPayloads()[idx] == idx);
+   }
+}
+
+// Each posting thread sends this many events.  The payload is
+// (thread index * POSTS_PER_THREAD + sequence).
+static const int32 POSTS_PER_THREAD = 5000;
+static const int32 POSTING_THREADS = 4;
+
+static void* PostingThread(void* arg)
+{
+   int32 threadIdx = (int32)(long)arg;
+   for(int32 idx = 0; idx < POSTS_PER_THREAD; idx++)
+   {
+      int32 value = threadIdx*POSTS_PER_THREAD + idx;
+      // If the queue is full, wait for the main thread to catch up.
+      while(!Notifier::Instance().Post(Notifier::NE_DEBUG_BUTTON_PRESSED, &value, sizeof(value)))
+      {
+         sched_yield();
+      }
+   }
+   return NULL;
+}
+
+// Verify several threads can post at the same time without losing
+// or reordering events.
+void TestNotifier::TestPostFromThreads()
+{
+   PayloadTarget target;
+   pthread_t threads[POSTING_THREADS];
+   
+   Notifier::Instance().Attach(&target, Notifier::NE_DEBUG_BUTTON_PRESSED);
+   
+   for(int32 idx = 0; idx < POSTING_THREADS; idx++)
+   {
+      CPPUNIT_ASSERT(pthread_create(&threads[idx], NULL, PostingThread, (void*)(long)idx) == 0);
+   }
+   // Act like the main loop.
+   int32 total = 0;
+   while(total < POSTING_THREADS*POSTS_PER_THREAD)
+   {
+      total += Notifier::Instance().DispatchPending(64);
+   }
+   for(int32 idx = 0; idx < POSTING_THREADS; idx++)
+   {
+      pthread_join(threads[idx], NULL);
+   }
+   CPPUNIT_ASSERT(Notifier::Instance().DispatchPending() == 0);
+   
+   // Every event arrived once, and the events from each thread
+   // arrived in the order they were posted.
+   const vector<int32>& payloads = target.GetPayloads();
+   CPPUNIT_ASSERT(payloads.size() == POSTING_THREADS*POSTS_PER_THREAD);
+   vector<int32> nextExpected(POSTING_THREADS, 0);
+   for(int32 idx = 0; idx < payloads.size(); idx++)
+   {
+      int32 threadIdx = payloads[idx]/POSTS_PER_THREAD;
+      int32 sequence = payloads[idx]%POSTS_PER_THREAD;
+      CPPUNIT_ASSERT(threadIdx >= 0 && threadIdx < POSTING_THREADS);
+      CPPUNIT_ASSERT(sequence == nextExpected[threadIdx]);
+      nextExpected[threadIdx]++;
+   }
+}
+
+// Verify an observer detached during a Notify(...) is not called.
+void TestNotifier::TestDetachViaNotify()
+{
+   RegisterTestObjects();
+   
+   // pNotifyTarget1 gets this first and detaches pNotifyTarget3 from the
+   // event.  pNotifyTarget3 is still registered for another event, so it
+   // is still alive, but it should not get this one.
+   Notifier::Instance().Notify(Notifier::NE_DEBUG_BUTTON_PRESSED,(void*)DetachNotifyTarget3FromButton);
+   
+   CPPUNIT_ASSERT(pNotifyTarget1->GetNotifications().size() == 1);
+   CPPUNIT_ASSERT(pNotifyTarget3->GetNotifications().size() == 0);
+   CPPUNIT_ASSERT(Notifier::Instance().GetNotified(Notifier::NE_DEBUG_BUTTON_PRESSED).size() == 1);
+   CPPUNIT_ASSERT(Notifier::Instance().GetEvents(pNotifyTarget3).size() == 1);
+   
+   // Everything still works after the tombstone is cleaned up.
+   ResetNotifyTargets();
+   Notifier::Instance().Notify(Notifier::NE_RESET_DRAW_CYCLE);
+   CPPUNIT_ASSERT(pNotifyTarget2->GetNotifications().size() == 1);
+   CPPUNIT_ASSERT(pNotifyTarget3->GetNotifications().size() == 1);
+}
+
+// Verify an observer attached during a Notify(...) only gets
+// the events sent after it attached.
+void TestNotifier::TestAttachViaNotify()
+{
+   RegisterTestObjects();
+   
+   Notifier::Instance().Notify(Notifier::NE_DEBUG_BUTTON_PRESSED,(void*)AttachNotifyTarget2ToButton);
+   CPPUNIT_ASSERT(pNotifyTarget1->GetNotifications().size() == 1);
+   CPPUNIT_ASSERT(pNotifyTarget2->GetNotifications().size() == 0);
+   CPPUNIT_ASSERT(pNotifyTarget3->GetNotifications().size() == 1);
+   
+   ResetNotifyTargets();
+   Notifier::Instance().Notify(Notifier::NE_DEBUG_BUTTON_PRESSED);
+   CPPUNIT_ASSERT(pNotifyTarget1->GetNotifications().size() == 1);
+   CPPUNIT_ASSERT(pNotifyTarget2->GetNotifications().size() == 1);
+   CPPUNIT_ASSERT(pNotifyTarget3->GetNotifications().size() == 1);
+}
+
+// Notifications with no payload and no side effects.
+class CountingTarget : public Notified
+{
+public:
+   uint32 count;
+   CountingTarget() : count(0) {}
+   virtual void Notify(Notifier::NOTIFIED_EVENT_TYPE_T eventType, const void* eventData)
+   {
+      count++;
+   }
+};
+
+// Verify Notify(...) does not allocate memory.
+void TestNotifier::TestNotifyDoesNotAllocate()
+{
+   const int32 TARGETS = 100;
+   vector<CountingTarget> targets(TARGETS);
+   
+   for(int32 idx = 0; idx < TARGETS; idx++)
+   {
+      Notifier::Instance().Attach(&targets[idx], Notifier::NE_DEBUG_LINE_DRAW_ADD_LINE_PIXELS);
+   }
+   
+   uint32 allocationsBefore = allocationCount;
+   for(int32 idx = 0; idx < 1000; idx++)
+   {
+      Notifier::Instance().Notify(Notifier::NE_DEBUG_LINE_DRAW_ADD_LINE_PIXELS);
+   }
+   CPPUNIT_ASSERT(allocationCount == allocationsBefore);
+   for(int32 idx = 0; idx < TARGETS; idx++)
+   {
+      CPPUNIT_ASSERT(targets[idx].count == 1000);
+   }
+}
+
+// Receives events through typed channels only.
+class TypedTarget : public NotifiedTyped
+{
+public:
+   vector<uint32> buttons;
+   uint32 resets;
+   
+   TypedTarget() : resets(0) {}
+   
+   void DebugButtonPressed(const uint32& button) { buttons.push_back(button); }
+   void ResetDrawCycle(const Notifier::NO_PAYLOAD_T& payload) { resets++; }
+};
+
+// Verify typed channel handlers get the payload, can be mixed
+// with untyped observers, and detach like everyone else.
+void TestNotifier::TestTypedChannel()
+{
+   typedef Notifier::Channel<Notifier::NE_DEBUG_BUTTON_PRESSED> BUTTON_CHANNEL_T;
+   typedef Notifier::Channel<Notifier::NE_RESET_DRAW_CYCLE> RESET_CHANNEL_T;
+   TypedTarget typedTarget;
+   PayloadTarget untypedTarget;
+   
+   BUTTON_CHANNEL_T().Attach<TypedTarget,&TypedTarget::DebugButtonPressed>(&typedTarget);
+   RESET_CHANNEL_T().Attach<TypedTarget,&TypedTarget::ResetDrawCycle>(&typedTarget);
+   Notifier::Instance().Attach(&untypedTarget, Notifier::NE_DEBUG_BUTTON_PRESSED);
+   
+   CPPUNIT_ASSERT(Notifier::Instance().GetEvents(&typedTarget).size() == 2);
+   CPPUNIT_ASSERT(Notifier::Instance().GetNotified(Notifier::NE_DEBUG_BUTTON_PRESSED).size() == 2);
+   
+   // Both kinds of observer get the payload.
+   BUTTON_CHANNEL_T().Notify(5);
+   CPPUNIT_ASSERT(typedTarget.buttons.size() == 1);
+   CPPUNIT_ASSERT(typedTarget.buttons[0] == 5);
+   CPPUNIT_ASSERT(untypedTarget.GetPayloads().size() == 1);
+   CPPUNIT_ASSERT(untypedTarget.GetPayloads()[0] == 5);
+   
+   // Events with no payload work from the channel or the untyped call.
+   RESET_CHANNEL_T().Notify();
+   Notifier::Instance().Notify(Notifier::NE_RESET_DRAW_CYCLE);
+   CPPUNIT_ASSERT(typedTarget.resets == 2);
+   
+   // Posting copies the payload.
+   uint32 button = 9;
+   CPPUNIT_ASSERT(BUTTON_CHANNEL_T().Post(button) == true);
+   button = 0;
+   CPPUNIT_ASSERT(typedTarget.buttons.size() == 1);
+   CPPUNIT_ASSERT(Notifier::Instance().DispatchPending() == 1);
+   CPPUNIT_ASSERT(typedTarget.buttons.size() == 2);
+   CPPUNIT_ASSERT(typedTarget.buttons[1] == 9);
+   
+   // Detaching from the channel only removes that event.
+   BUTTON_CHANNEL_T().Detach(&typedTarget);
+   BUTTON_CHANNEL_T().Notify(6);
+   CPPUNIT_ASSERT(typedTarget.buttons.size() == 2);
+   CPPUNIT_ASSERT(untypedTarget.GetPayloads().size() == 3);
+   CPPUNIT_ASSERT(Notifier::Instance().GetEvents(&typedTarget).size() == 1);
+   
+   // Deleting a typed observer detaches it.
+   TypedTarget* pTypedTarget = new TypedTarget();
+   BUTTON_CHANNEL_T().Attach<TypedTarget,&TypedTarget::DebugButtonPressed>(pTypedTarget);
+   CPPUNIT_ASSERT(Notifier::Instance().GetNotified(Notifier::NE_DEBUG_BUTTON_PRESSED).size() == 2);
+   delete pTypedTarget;
+   CPPUNIT_ASSERT(Notifier::Instance().GetNotified(Notifier::NE_DEBUG_BUTTON_PRESSED).size() == 1);
+   BUTTON_CHANNEL_T().Notify(7);
+   CPPUNIT_ASSERT(untypedTarget.GetPayloads().size() == 4);
+}
+
+// Takes batches of int32 in one call through the untyped interface.
+class BatchTarget : public NotifiedBatch
+{
+public:
+   vector<vector<int32> > batches;
+   uint32 singles;
+   
+   BatchTarget() : singles(0) {}
+   
+   virtual void Notify(Notifier::NOTIFIED_EVENT_TYPE_T eventType, const void* eventData)
+   {
+      singles++;
+   }
+   
+   virtual void NotifyBatch(Notifier::NOTIFIED_EVENT_TYPE_T eventType, const void* items, uint32 itemSize, uint32 count)
+   {
+      CPPUNIT_ASSERT(itemSize == sizeof(int32));
+      const int32* values = (const int32*)items;
+      batches.push_back(vector<int32>(values, values+count));
+   }
+};
+
+// Takes batches of buttons through a typed channel.
+class TypedBatchTarget : public NotifiedTyped
+{
+public:
+   vector<vector<uint32> > batches;
+   
+   void DebugButtonsPressed(const uint32* buttons, uint32 count)
+   {
+      batches.push_back(vector<uint32>(buttons, buttons+count));
+   }
+};
+
+// Verify batch observers get a batch in one call and everyone
+// else gets one notification per item.
+void TestNotifier::TestNotifyBatch()
+{
+   typedef Notifier::Channel<Notifier::NE_DEBUG_BUTTON_PRESSED> BUTTON_CHANNEL_T;
+   BatchTarget batchTarget;
+   TypedBatchTarget typedBatchTarget;
+   PayloadTarget untypedTarget;
+   int32 values[5] = { 10, 11, 12, 13, 14 };
+   
+   Notifier::Instance().AttachBatch(&batchTarget, Notifier::NE_DEBUG_BUTTON_PRESSED);
+   Notifier::Instance().Attach(&untypedTarget, Notifier::NE_DEBUG_BUTTON_PRESSED);
+   BUTTON_CHANNEL_T().AttachBatch<TypedBatchTarget,&TypedBatchTarget::DebugButtonsPressed>(&typedBatchTarget);
+   
+   Notifier::Instance().NotifyBatch(Notifier::NE_DEBUG_BUTTON_PRESSED, values, 5);
+   
+   CPPUNIT_ASSERT(batchTarget.batches.size() == 1);
+   CPPUNIT_ASSERT(batchTarget.batches[0].size() == 5);
+   CPPUNIT_ASSERT(batchTarget.singles == 0);
+   CPPUNIT_ASSERT(typedBatchTarget.batches.size() == 1);
+   CPPUNIT_ASSERT(typedBatchTarget.batches[0].size() == 5);
+   CPPUNIT_ASSERT(untypedTarget.GetPayloads().size() == 5);
+   for(int32 idx = 0; idx < 5; idx++)
+   {
+      CPPUNIT_ASSERT(batchTarget.batches[0][idx] == values[idx]);
+      CPPUNIT_ASSERT(typedBatchTarget.batches[0][idx] == values[idx]);
+      CPPUNIT_ASSERT(untypedTarget.GetPayloads()[idx] == values[idx]);
+   }
+   
+   // A single event goes through Notify(...) for the untyped batch observer
+   // and as a batch of one for the typed one.
+   BUTTON_CHANNEL_T().Notify(3);
+   CPPUNIT_ASSERT(batchTarget.singles == 1);
+   CPPUNIT_ASSERT(typedBatchTarget.batches.size() == 2);
+   CPPUNIT_ASSERT(typedBatchTarget.batches[1].size() == 1);
+   CPPUNIT_ASSERT(typedBatchTarget.batches[1][0] == 3);
+   
+   // An empty batch is fine.
+   BUTTON_CHANNEL_T().NotifyBatch(NULL, 0);
+   CPPUNIT_ASSERT(batchTarget.batches.size() == 2);
+   CPPUNIT_ASSERT(untypedTarget.GetPayloads().size() == 6);
+   
+   CPPUNIT_ASSERT_THROW(Notifier::Instance().NotifyBatch(Notifier::NE_MAX, values, 5), std::out_of_range);
+   CPPUNIT_ASSERT_THROW(Notifier::Instance().NotifyBatch(Notifier::NE_MIN, NULL, sizeof(int32), 5), std::out_of_range);
+}
+
+// Records the order observers are called in.  An observer with
+// consume set eats the button events it gets.
+class OrderTarget : public Notified
+{
+private:
+   vector<int32>& _order;
+   int32 _id;
+   
+public:
+   bool consume;
+   OrderTarget* attachOnNotify;
+   
+   OrderTarget(vector<int32>& order, int32 id) :
+      _order(order),
+      _id(id),
+      consume(false),
+      attachOnNotify(NULL)
+   {
+   }
+   
+   bool DebugButtonPressed(const uint32& button)
+   {
+      _order.push_back(_id);
+      if(attachOnNotify != NULL)
+      {
+         Notifier::Channel<Notifier::NE_DEBUG_BUTTON_PRESSED>().Attach<OrderTarget,&OrderTarget::DebugButtonPressed>(attachOnNotify, 100);
+         attachOnNotify = NULL;
+      }
+      return consume;
+   }
+   
+   virtual void Notify(Notifier::NOTIFIED_EVENT_TYPE_T eventType, const void* eventData)
+   {
+      _order.push_back(_id);
+   }
+};
+
+// Verify observers are called highest priority first, in attach
+// order for equal priorities, and stay that way after a Detach.
+void TestNotifier::TestPriorityOrder()
+{
+   vector<int32> order;
+   OrderTarget target0(order, 0);
+   OrderTarget target1(order, 1);
+   OrderTarget target2(order, 2);
+   OrderTarget target3(order, 3);
+   OrderTarget target4(order, 4);
+   
+   Notifier::Instance().Attach(&target0, Notifier::NE_RESET_DRAW_CYCLE);
+   Notifier::Instance().Attach(&target1, Notifier::NE_RESET_DRAW_CYCLE, 10);
+   Notifier::Instance().Attach(&target2, Notifier::NE_RESET_DRAW_CYCLE, -5);
+   Notifier::Instance().Attach(&target3, Notifier::NE_RESET_DRAW_CYCLE, 10);
+   Notifier::Instance().Attach(&target4, Notifier::NE_RESET_DRAW_CYCLE);
+   
+   Notifier::Instance().Notify(Notifier::NE_RESET_DRAW_CYCLE);
+   CPPUNIT_ASSERT(order.size() == 5);
+   CPPUNIT_ASSERT(order[0] == 1);
+   CPPUNIT_ASSERT(order[1] == 3);
+   CPPUNIT_ASSERT(order[2] == 0);
+   CPPUNIT_ASSERT(order[3] == 4);
+   CPPUNIT_ASSERT(order[4] == 2);
+   
+   // Re-attaching does not change the priority.
+   Notifier::Instance().Attach(&target2, Notifier::NE_RESET_DRAW_CYCLE, 50);
+   Notifier::Instance().Detach(&target3, Notifier::NE_RESET_DRAW_CYCLE);
+   order.clear();
+   Notifier::Instance().Notify(Notifier::NE_RESET_DRAW_CYCLE);
+   CPPUNIT_ASSERT(order.size() == 4);
+   CPPUNIT_ASSERT(order[0] == 1);
+   CPPUNIT_ASSERT(order[1] == 0);
+   CPPUNIT_ASSERT(order[2] == 4);
+   CPPUNIT_ASSERT(order[3] == 2);
+}
+
+// Verify a handler that consumes an event stops it from going
+// to lower priority observers, and that the caller is told.
+void TestNotifier::TestConsumeEvent()
+{
+   typedef Notifier::Channel<Notifier::NE_DEBUG_BUTTON_PRESSED> BUTTON_CHANNEL_T;
+   vector<int32> order;
+   OrderTarget target0(order, 0);
+   OrderTarget target1(order, 1);
+   OrderTarget target2(order, 2);
+   
+   BUTTON_CHANNEL_T().Attach<OrderTarget,&OrderTarget::DebugButtonPressed>(&target0, 1);
+   BUTTON_CHANNEL_T().Attach<OrderTarget,&OrderTarget::DebugButtonPressed>(&target1, 2);
+   Notifier::Instance().Attach(&target2, Notifier::NE_DEBUG_BUTTON_PRESSED);
+   
+   CPPUNIT_ASSERT(BUTTON_CHANNEL_T().Notify(1) == false);
+   CPPUNIT_ASSERT(order.size() == 3);
+   CPPUNIT_ASSERT(order[0] == 1);
+   CPPUNIT_ASSERT(order[1] == 0);
+   CPPUNIT_ASSERT(order[2] == 2);
+   
+   order.clear();
+   target1.consume = true;
+   CPPUNIT_ASSERT(BUTTON_CHANNEL_T().Notify(1) == true);
+   CPPUNIT_ASSERT(order.size() == 1);
+   CPPUNIT_ASSERT(order[0] == 1);
+   
+   // Posted events are consumed the same way.
+   order.clear();
+   CPPUNIT_ASSERT(BUTTON_CHANNEL_T().Post(1) == true);
+   CPPUNIT_ASSERT(Notifier::Instance().DispatchPending() == 1);
+   CPPUNIT_ASSERT(order.size() == 1);
+   
+   // Batches are not consumed.
+   order.clear();
+   uint32 buttons[2] = { 1, 2 };
+   BUTTON_CHANNEL_T().NotifyBatch(buttons, 2);
+   CPPUNIT_ASSERT(order.size() == 6);
+}
+
+// Verify a high priority observer attached during a Notify(...)
+// is not called for that event but is first in line afterwards.
+void TestNotifier::TestPriorityAttachViaNotify()
+{
+   typedef Notifier::Channel<Notifier::NE_DEBUG_BUTTON_PRESSED> BUTTON_CHANNEL_T;
+   vector<int32> order;
+   OrderTarget target0(order, 0);
+   OrderTarget target1(order, 1);
+   OrderTarget target2(order, 2);
+   
+   BUTTON_CHANNEL_T().Attach<OrderTarget,&OrderTarget::DebugButtonPressed>(&target0);
+   BUTTON_CHANNEL_T().Attach<OrderTarget,&OrderTarget::DebugButtonPressed>(&target1);
+   target0.attachOnNotify = &target2;
+   
+   BUTTON_CHANNEL_T().Notify(1);
+   CPPUNIT_ASSERT(order.size() == 2);
+   CPPUNIT_ASSERT(order[0] == 0);
+   CPPUNIT_ASSERT(order[1] == 1);
+   
+   order.clear();
+   BUTTON_CHANNEL_T().Notify(1);
+   CPPUNIT_ASSERT(order.size() == 3);
+   CPPUNIT_ASSERT(order[0] == 2);
+   CPPUNIT_ASSERT(order[1] == 0);
+   CPPUNIT_ASSERT(order[2] == 1);
+}
+
+// Benchmark tearing down a scene full of observers.  Each one detaches
+// in its destructor, which used to be a search of every list it was in.
+void TestNotifier::TestTeardownBenchmark()
+{
+   const uint32 OBSERVERS = 100000;
+   vector<CountingTarget*> targets;
+   targets.reserve(OBSERVERS);
+   
+   clock_t start = clock();
+   for(uint32 idx = 0; idx < OBSERVERS; idx++)
+   {
+      CountingTarget* target = new CountingTarget();
+      Notifier::Instance().Attach(target, Notifier::NE_DEBUG_BUTTON_PRESSED);
+      Notifier::Instance().Attach(target, Notifier::NE_RESET_DRAW_CYCLE);
+      targets.push_back(target);
+   }
+   double attachSeconds = (double)(clock() - start)/CLOCKS_PER_SEC;
+   CPPUNIT_ASSERT(Notifier::Instance().GetNotified(Notifier::NE_DEBUG_BUTTON_PRESSED).size() == OBSERVERS);
+   
+   Notifier::Instance().Notify(Notifier::NE_RESET_DRAW_CYCLE);
+   CPPUNIT_ASSERT(targets[OBSERVERS-1]->count == 1);
+   
+   // Delete them in the order they were attached, the worst case for
+   // erasing from the front of the lists.
+   start = clock();
+   for(uint32 idx = 0; idx < OBSERVERS; idx++)
+   {
+      delete targets[idx];
+   }
+   double teardownSeconds = (double)(clock() - start)/CLOCKS_PER_SEC;
+   targets.clear();
+   
+   CPPUNIT_ASSERT(Notifier::Instance().GetNotified(Notifier::NE_DEBUG_BUTTON_PRESSED).size() == 0);
+   CPPUNIT_ASSERT(Notifier::Instance().GetNotified(Notifier::NE_RESET_DRAW_CYCLE).size() == 0);
+   
+   cout << endl << "   Attach " << OBSERVERS << " observers: " << attachSeconds*1000 << " ms, teardown: " << teardownSeconds*1000 << " ms" << endl;
+   // Linear teardown takes a few milliseconds.  A quadratic one takes
+   // minutes.
+   CPPUNIT_ASSERT(teardownSeconds < 2.0);
+}
+
+// Verify repeated posts of coalesced events collapse into one delivery
+// with the first (DP_COALESCE) or last (DP_LAST_VALUE) payload.
+void TestNotifier::TestDeliveryPolicy()
+{
+   Notifier& notifier = Notifier::Instance();
+   PayloadTarget buttonTarget;
+   CountingTarget resetTarget;
+   notifier.Attach(&buttonTarget, Notifier::NE_DEBUG_BUTTON_PRESSED);
+   notifier.Attach(&resetTarget, Notifier::NE_RESET_DRAW_CYCLE);
+   
+   CPPUNIT_ASSERT(notifier.GetDeliveryPolicy(Notifier::NE_DEBUG_BUTTON_PRESSED) == Notifier::DP_IMMEDIATE);
+   
+   notifier.SetDeliveryPolicy(Notifier::NE_DEBUG_BUTTON_PRESSED, Notifier::DP_COALESCE);
+   for(int32 value = 1; value <= 3; value++)
+   {
+      CPPUNIT_ASSERT(notifier.Post(Notifier::NE_DEBUG_BUTTON_PRESSED, &value, sizeof(value)) == true);
+   }
+   CPPUNIT_ASSERT(notifier.DispatchPending() == 1);
+   CPPUNIT_ASSERT(buttonTarget.GetPayloads().size() == 1);
+   CPPUNIT_ASSERT(buttonTarget.GetPayloads()[0] == 1);
+   
+   notifier.SetDeliveryPolicy(Notifier::NE_DEBUG_BUTTON_PRESSED, Notifier::DP_LAST_VALUE);
+   for(int32 value = 4; value <= 6; value++)
+   {
+      CPPUNIT_ASSERT(notifier.Post(Notifier::NE_DEBUG_BUTTON_PRESSED, &value, sizeof(value)) == true);
+   }
+   CPPUNIT_ASSERT(notifier.DispatchPending() == 1);
+   CPPUNIT_ASSERT(buttonTarget.GetPayloads().size() == 2);
+   CPPUNIT_ASSERT(buttonTarget.GetPayloads()[1] == 6);
+   
+   // Immediate events are delivered as they come, coalesced ones at the
+   // end.
+   notifier.SetDeliveryPolicy(Notifier::NE_DEBUG_BUTTON_PRESSED, Notifier::DP_IMMEDIATE);
+   notifier.SetDeliveryPolicy(Notifier::NE_RESET_DRAW_CYCLE, Notifier::DP_COALESCE);
+   int32 value = 7;
+   notifier.Post(Notifier::NE_RESET_DRAW_CYCLE);
+   notifier.Post(Notifier::NE_DEBUG_BUTTON_PRESSED, &value, sizeof(value));
+   notifier.Post(Notifier::NE_RESET_DRAW_CYCLE);
+   notifier.Post(Notifier::NE_DEBUG_BUTTON_PRESSED, &value, sizeof(value));
+   CPPUNIT_ASSERT(notifier.DispatchPending() == 3);
+   CPPUNIT_ASSERT(buttonTarget.GetPayloads().size() == 4);
+   CPPUNIT_ASSERT(resetTarget.count == 1);
+   
+   // Each DispatchPending(...) is a separate frame.  The budget counts
+   // the posts taken from the queue.
+   notifier.Post(Notifier::NE_RESET_DRAW_CYCLE);
+   notifier.Post(Notifier::NE_RESET_DRAW_CYCLE);
+   notifier.Post(Notifier::NE_RESET_DRAW_CYCLE);
+   CPPUNIT_ASSERT(notifier.DispatchPending(2) == 1);
+   CPPUNIT_ASSERT(notifier.DispatchPending() == 1);
+   CPPUNIT_ASSERT(resetTarget.count == 3);
+   
+   // Notify(...) is never held.
+   notifier.Notify(Notifier::NE_RESET_DRAW_CYCLE);
+   notifier.Notify(Notifier::NE_RESET_DRAW_CYCLE);
+   CPPUNIT_ASSERT(resetTarget.count == 5);
+   
+   CPPUNIT_ASSERT_THROW(notifier.SetDeliveryPolicy(Notifier::NE_MAX, Notifier::DP_COALESCE), std::out_of_range);
+   CPPUNIT_ASSERT_THROW(notifier.GetDeliveryPolicy(Notifier::NE_MAX), std::out_of_range);
+   
+   notifier.Reset();
+   CPPUNIT_ASSERT(notifier.GetDeliveryPolicy(Notifier::NE_RESET_DRAW_CYCLE) == Notifier::DP_IMMEDIATE);
+}
+
+// Verify separate Notifiers keep separate observers, one observer can
+// be attached to several, and either side can go away first.
+void TestNotifier::TestMultipleNotifiers()
+{
+   typedef Notifier::Channel<Notifier::NE_DEBUG_BUTTON_PRESSED> BUTTON_CHANNEL_T;
+   Notifier& global = Notifier::Instance();
+   Notifier local;
+   CPPUNIT_ASSERT(local.Init() == true);
+   
+   TypedTarget shared;
+   CountingTarget localOnly;
+   BUTTON_CHANNEL_T(global).Attach<TypedTarget,&TypedTarget::DebugButtonPressed>(&shared);
+   BUTTON_CHANNEL_T(local).Attach<TypedTarget,&TypedTarget::DebugButtonPressed>(&shared);
+   local.Attach(&localOnly, Notifier::NE_DEBUG_BUTTON_PRESSED);
+   
+   CPPUNIT_ASSERT(global.GetNotified(Notifier::NE_DEBUG_BUTTON_PRESSED).size() == 1);
+   CPPUNIT_ASSERT(local.GetNotified(Notifier::NE_DEBUG_BUTTON_PRESSED).size() == 2);
+   CPPUNIT_ASSERT(global.GetEvents(&localOnly).size() == 0);
+   CPPUNIT_ASSERT(local.GetEvents(&localOnly).size() == 1);
+   
+   BUTTON_CHANNEL_T(global).Notify(1);
+   CPPUNIT_ASSERT(shared.buttons.size() == 1);
+   CPPUNIT_ASSERT(localOnly.count == 0);
+   BUTTON_CHANNEL_T(local).Notify(2);
+   CPPUNIT_ASSERT(shared.buttons.size() == 2);
+   CPPUNIT_ASSERT(shared.buttons[1] == 2);
+   CPPUNIT_ASSERT(localOnly.count == 1);
+   
+   // Posted events stay with their Notifier.
+   BUTTON_CHANNEL_T(local).Post(3);
+   CPPUNIT_ASSERT(global.DispatchPending() == 0);
+   CPPUNIT_ASSERT(local.DispatchPending() == 1);
+   CPPUNIT_ASSERT(localOnly.count == 2);
+   
+   // Detaching from one leaves the other alone.
+   global.Detach(&shared);
+   CPPUNIT_ASSERT(global.GetEvents(&shared).size() == 0);
+   CPPUNIT_ASSERT(local.GetEvents(&shared).size() == 1);
+   
+   // An observer that is destroyed detaches from every Notifier.
+   CountingTarget* both = new CountingTarget();
+   global.Attach(both, Notifier::NE_RESET_DRAW_CYCLE);
+   local.Attach(both, Notifier::NE_RESET_DRAW_CYCLE);
+   delete both;
+   CPPUNIT_ASSERT(global.GetNotified(Notifier::NE_RESET_DRAW_CYCLE).size() == 0);
+   CPPUNIT_ASSERT(local.GetNotified(Notifier::NE_RESET_DRAW_CYCLE).size() == 0);
+   
+   // A Notifier that is destroyed lets go of its observers.
+   CountingTarget survivor;
+   {
+      Notifier scoped;
+      scoped.Init();
+      scoped.Attach(&survivor, Notifier::NE_RESET_DRAW_CYCLE);
+      global.Attach(&survivor, Notifier::NE_RESET_DRAW_CYCLE);
+   }
+   global.Notify(Notifier::NE_RESET_DRAW_CYCLE);
+   CPPUNIT_ASSERT(survivor.count == 1);
+   CPPUNIT_ASSERT(global.GetEvents(&survivor).size() == 1);
+}
+
+#ifdef NOTIFIER_STATS
+// Verify the statistics count dispatches, observer calls and nesting
+// for each event, and that they can be dumped and reset.
+void TestNotifier::TestStats()
+{
+   Notifier& notifier = Notifier::Instance();
+   RegisterTestObjects();
+   
+   // Targets 1 and 3 get the button, and each sends a reset, which goes
+   // to targets 2 and 3 one level down.
+   notifier.Notify(Notifier::NE_DEBUG_BUTTON_PRESSED, (void*)NotifyResetDrawCycle);
+   
+   const Notifier::EVENT_STATS_T& buttonStats = notifier.GetStats(Notifier::NE_DEBUG_BUTTON_PRESSED);
+   CPPUNIT_ASSERT(buttonStats.dispatches == 1);
+   CPPUNIT_ASSERT(buttonStats.observersCalled == 2);
+   CPPUNIT_ASSERT(buttonStats.maxDepth == 1);
+   const Notifier::EVENT_STATS_T& resetStats = notifier.GetStats(Notifier::NE_RESET_DRAW_CYCLE);
+   CPPUNIT_ASSERT(resetStats.dispatches == 2);
+   CPPUNIT_ASSERT(resetStats.observersCalled == 4);
+   CPPUNIT_ASSERT(resetStats.maxDepth == 2);
+   // The button calls include the reset calls they made.
+   CPPUNIT_ASSERT(buttonStats.callNanoseconds >= resetStats.callNanoseconds);
+   
+   uint32 histogramTotal = 0;
+   for(uint32 bucket = 0; bucket < Notifier::STATS_HISTOGRAM_BUCKETS; bucket++)
+   {
+      histogramTotal += resetStats.histogram[bucket];
+   }
+   CPPUNIT_ASSERT(histogramTotal == 4);
+   
+   // A batch is one dispatch and one call per observer.  Target 1 would
+   // treat the items as functions, so use a counter instead.
+   CountingTarget counter;
+   notifier.Detach(pNotifyTarget1, Notifier::NE_DEBUG_LINE_DRAW_ADD_LINE_PIXELS);
+   notifier.Attach(&counter, Notifier::NE_DEBUG_LINE_DRAW_ADD_LINE_PIXELS);
+   int32 lines[3] = { 0, 0, 0 };
+   notifier.NotifyBatch(Notifier::NE_DEBUG_LINE_DRAW_ADD_LINE_PIXELS, lines, 3);
+   const Notifier::EVENT_STATS_T& lineStats = notifier.GetStats(Notifier::NE_DEBUG_LINE_DRAW_ADD_LINE_PIXELS);
+   CPPUNIT_ASSERT(lineStats.dispatches == 1);
+   CPPUNIT_ASSERT(lineStats.observersCalled == 1);
+   CPPUNIT_ASSERT(counter.count == 3);
+   
+   // Only events that were dispatched are dumped.
+   ostringstream dump;
+   notifier.DumpStats(dump);
+   CPPUNIT_ASSERT(dump.str().find("histogram") != string::npos);
+   
+   notifier.ResetStats();
+   CPPUNIT_ASSERT(buttonStats.dispatches == 0);
+   CPPUNIT_ASSERT(resetStats.observersCalled == 0);
+   CPPUNIT_ASSERT(resetStats.maxDepth == 0);
+   CPPUNIT_ASSERT(resetStats.histogram[0] == 0);
+   
+   CPPUNIT_ASSERT_THROW(notifier.GetStats(Notifier::NE_MAX), std::out_of_range);
+}
+#endif
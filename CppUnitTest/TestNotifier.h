@@ -60,6 +60,50 @@ public:
    // Verify if you register for the same even twice, you
    // only receive it once.
    void TestDoubleAttach();
+   // Verify Post(...) defers delivery until DispatchPending(...).
+   void TestPostDeferred();
+   // Verify a posted payload is copied and the budget is honored.
+   void TestPostPayloadAndBudget();
+   // Verify Post(...) fails cleanly when the queue is full.
+   void TestPostQueueFull();
+   // Verify several threads can post at the same time without losing
+   // or reordering events.
+   void TestPostFromThreads();
+   // Verify an observer detached during a Notify(...) is not called.
+   void TestDetachViaNotify();
+   // Verify an observer attached during a Notify(...) only gets
+   // the events sent after it attached.
+   void TestAttachViaNotify();
+   // Verify Notify(...) does not allocate memory.
+   void TestNotifyDoesNotAllocate();
+   // Verify typed channel handlers get the payload, can be mixed
+   // with untyped observers, and detach like everyone else.
+   void TestTypedChannel();
+   // Verify batch observers get a batch in one call and everyone
+   // else gets one notification per item.
+   void TestNotifyBatch();
+   // Verify observers are called highest priority first, in attach
+   // order for equal priorities, and stay that way after a Detach.
+   void TestPriorityOrder();
+   // Verify a handler that consumes an event stops it from going
+   // to lower priority observers, and that the caller is told.
+   void TestConsumeEvent();
+   // Verify a high priority observer attached during a Notify(...)
+   // is not called for that event but is first in line afterwards.
+   void TestPriorityAttachViaNotify();
+   // Benchmark tearing down a scene full of observers.
+   void TestTeardownBenchmark();
+   // Verify repeated posts of coalesced events collapse into one delivery
+   // with the first (DP_COALESCE) or last (DP_LAST_VALUE) payload.
+   void TestDeliveryPolicy();
+   // Verify separate Notifiers keep separate observers, one observer can
+   // be attached to several, and either side can go away first.
+   void TestMultipleNotifiers();
+#ifdef NOTIFIER_STATS
+   // Verify the statistics count dispatches, observer calls and nesting
+   // for each event, and that they can be dumped and reset.
+   void TestStats();
+#endif
    
    void setUp();
    void tearDown();
@@ -77,6 +121,24 @@ public:
    CPPUNIT_TEST(TestDeleteViaNotify);
    CPPUNIT_TEST(TestReset);
    CPPUNIT_TEST(TestInputArguments);
+   CPPUNIT_TEST(TestPostDeferred);
+   CPPUNIT_TEST(TestPostPayloadAndBudget);
+   CPPUNIT_TEST(TestPostQueueFull);
+   CPPUNIT_TEST(TestPostFromThreads);
+   CPPUNIT_TEST(TestDetachViaNotify);
+   CPPUNIT_TEST(TestAttachViaNotify);
+   CPPUNIT_TEST(TestNotifyDoesNotAllocate);
+   CPPUNIT_TEST(TestTypedChannel);
+   CPPUNIT_TEST(TestNotifyBatch);
+   CPPUNIT_TEST(TestPriorityOrder);
+   CPPUNIT_TEST(TestConsumeEvent);
+   CPPUNIT_TEST(TestPriorityAttachViaNotify);
+   CPPUNIT_TEST(TestTeardownBenchmark);
+   CPPUNIT_TEST(TestDeliveryPolicy);
+   CPPUNIT_TEST(TestMultipleNotifiers);
+#ifdef NOTIFIER_STATS
+   CPPUNIT_TEST(TestStats);
+#endif
    CPPUNIT_TEST_SUITE_END();
    
 };
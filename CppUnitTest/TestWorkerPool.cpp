@@ -0,0 +1,129 @@
+/********************************************************************
+ * File   : TestWorkerPool.cpp
+ * Project: CppUnitTest
+ *
+ ********************************************************************
+ * Created on 10/20/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+#include "TestWorkerPool.h"
+#include "WorkerPool.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TestWorkerPool);
+
+/* Each item bumps its own counter, so we can check every item ran
+ * exactly once.
+ */
+typedef struct
+{
+   vector<uint32> hits;
+} HIT_COUNTS_T;
+
+static void CountHit(void* context, uint32 index)
+{
+   HIT_COUNTS_T* counts = (HIT_COUNTS_T*)context;
+   __sync_fetch_and_add(&counts->hits[index], 1);
+}
+
+static bool RunAndCheck(WorkerPool& pool, uint32 count)
+{
+   HIT_COUNTS_T counts;
+   counts.hits.resize(count, 0);
+   pool.ParallelFor(count, CountHit, &counts);
+   for(uint32 idx = 0; idx < count; idx++)
+   {
+      if(counts.hits[idx] != 1)
+      {
+         return false;
+      }
+   }
+   return true;
+}
+
+TestWorkerPool::TestWorkerPool()
+{
+   
+}
+
+TestWorkerPool::~TestWorkerPool()
+{
+   
+}
+
+void TestWorkerPool::setUp()
+{
+   
+}
+
+void TestWorkerPool::tearDown()
+{
+   
+}
+
+// Verify ParallelFor(...) with no worker threads runs every item
+// on the caller.
+void TestWorkerPool::TestNoWorkers()
+{
+   WorkerPool pool;
+   CPPUNIT_ASSERT(RunAndCheck(pool, 8));
+   pool.Init(0);
+   CPPUNIT_ASSERT(pool.GetThreadCount() == 0);
+   CPPUNIT_ASSERT(RunAndCheck(pool, 8));
+   CPPUNIT_ASSERT_THROW(pool.ParallelFor(8, NULL, NULL), std::out_of_range);
+   pool.Shutdown();
+}
+
+// Verify a ParallelFor(...) straight after Init(...) finishes and
+// runs every item once, even if the workers have not started yet.
+void TestWorkerPool::TestParallelForAfterInit()
+{
+   const uint32 ROUNDS = 200;
+   
+   for(uint32 round = 0; round < ROUNDS; round++)
+   {
+      WorkerPool pool;
+      pool.Init(4);
+      CPPUNIT_ASSERT(RunAndCheck(pool, 8));
+      pool.Shutdown();
+   }
+   // Restarting a pool must not confuse the new workers either.
+   WorkerPool pool;
+   for(uint32 round = 0; round < ROUNDS; round++)
+   {
+      pool.Init(4);
+      CPPUNIT_ASSERT(RunAndCheck(pool, 8));
+      pool.Shutdown();
+   }
+}
+
+// Verify many jobs in a row on the same pool each run every item once.
+void TestWorkerPool::TestRepeatedParallelFor()
+{
+   const uint32 ROUNDS = 1000;
+   
+   WorkerPool pool;
+   pool.Init(4);
+   for(uint32 round = 0; round < ROUNDS; round++)
+   {
+      CPPUNIT_ASSERT(RunAndCheck(pool, 1 + round%37));
+   }
+   pool.Shutdown();
+}
@@ -0,0 +1,64 @@
+/********************************************************************
+ * File   : TestWorkerPool.h
+ * Project: CppUnitTest
+ *
+ ********************************************************************
+ * Created on 10/20/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+#ifndef __CppUnitTest__TestWorkerPool__
+#define __CppUnitTest__TestWorkerPool__
+
+#include <cppunit/TestCase.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+
+/* Executes unit tests against the "WorkerPool" class.
+ */
+class TestWorkerPool : public CppUnit::TestFixture
+{
+   
+public:
+   TestWorkerPool();
+   ~TestWorkerPool();
+   
+   // Verify ParallelFor(...) with no worker threads runs every item
+   // on the caller.
+   void TestNoWorkers();
+   // Verify a ParallelFor(...) straight after Init(...) finishes and
+   // runs every item once, even if the workers have not started yet.
+   void TestParallelForAfterInit();
+   // Verify many jobs in a row on the same pool each run every item once.
+   void TestRepeatedParallelFor();
+   
+   void setUp();
+   void tearDown();
+   
+public:
+   CPPUNIT_TEST_SUITE(TestWorkerPool);
+   CPPUNIT_TEST(TestNoWorkers);
+   CPPUNIT_TEST(TestParallelForAfterInit);
+   CPPUNIT_TEST(TestRepeatedParallelFor);
+   CPPUNIT_TEST_SUITE_END();
+   
+};
+
+#endif /* defined(__CppUnitTest__TestWorkerPool__) */
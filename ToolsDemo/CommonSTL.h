@@ -37,6 +37,7 @@
 #include <cassert>
 #include <sstream>
 #include <stdexcept>
+#include <cstring>
 #include <tr1/unordered_map>
 
 using namespace std;
@@ -32,7 +32,7 @@
 #include "Notifier.h"
 
 
-class DebugLinesLayer : public CCLayer, public Notified
+class DebugLinesLayer : public CCLayer, public NotifiedTyped
 {
 private:
    
@@ -52,9 +52,9 @@ private:
       Reset();
       
       
-      Notifier::Instance().Attach(this, Notifier::NE_RESET_DRAW_CYCLE);
-      Notifier::Instance().Attach(this, Notifier::NE_DEBUG_LINE_DRAW_ADD_LINE_PIXELS);
-      Notifier::Instance().Attach(this, Notifier::NE_DEBUG_LINES_TOGGLE_VISIBILITY);
+      Notifier::Channel<Notifier::NE_RESET_DRAW_CYCLE>().Attach<DebugLinesLayer,&DebugLinesLayer::ResetDrawCycle>(this);
+      Notifier::Channel<Notifier::NE_DEBUG_LINE_DRAW_ADD_LINE_PIXELS>().AttachBatch<DebugLinesLayer,&DebugLinesLayer::AddLines>(this);
+      Notifier::Channel<Notifier::NE_DEBUG_LINES_TOGGLE_VISIBILITY>().Attach<DebugLinesLayer,&DebugLinesLayer::ToggleVisibility>(this);
       
       return true;
    }
@@ -82,10 +82,15 @@ public:
    void SetEnabled(bool enabled) { _enabled = enabled; }
    bool GetEnabled() { return _enabled; }
    
-   void AddLine(const LINE_PIXELS_DATA_T lpd)
+   void AddLine(const LINE_PIXELS_DATA_T& lpd)
    {
       _lineData.push_back(lpd);
    }
+   
+   void AddLines(const LINE_PIXELS_DATA_T* lpd, uint32 count)
+   {
+      _lineData.insert(_lineData.end(), lpd, lpd+count);
+   }
       
    
    virtual void draw()
@@ -109,23 +114,15 @@ public:
       }
    }
    
-   virtual void Notify(Notifier::NOTIFIED_EVENT_TYPE_T eventType, const void* eventData)
+   // Handlers for Notifier Events
+   void ResetDrawCycle(const Notifier::NO_PAYLOAD_T& payload)
    {
-      switch(eventType)
-      {
-         case Notifier::NE_RESET_DRAW_CYCLE:
-            Reset();
-            break;
-         case Notifier::NE_DEBUG_LINE_DRAW_ADD_LINE_PIXELS:
-            AddLine(*((LINE_PIXELS_DATA_T*)eventData));
-            break;
-         case Notifier::NE_DEBUG_LINES_TOGGLE_VISIBILITY:
-            setVisible(!isVisible());
-            break;
-         default:
-            assert(false);
-            break;
-      }
+      Reset();
+   }
+   
+   void ToggleVisibility(const Notifier::NO_PAYLOAD_T& payload)
+   {
+      setVisible(!isVisible());
    }
    
    static DebugLinesLayer* create()
@@ -71,7 +71,7 @@ void DebugMenuLayer::ButtonPressed(CCObject* pSender)
    CCNode* node = (CCNode*) pSender;
    int tag = node->getTag();
    CCLOG("Button with tag %d Pressed",tag);
-   Notifier::Instance().Notify(Notifier::NE_DEBUG_BUTTON_PRESSED, (void*)tag);
+   Notifier::Channel<Notifier::NE_DEBUG_BUTTON_PRESSED>().Notify(tag);
 }
 
 
@@ -0,0 +1,127 @@
+/********************************************************************
+ * File   : LineSimplifier.cpp
+ * Project: ToolsDemo
+ *
+ ********************************************************************
+ * Created on 10/19/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+#include "LineSimplifier.h"
+
+RadialDistanceFilter::RadialDistanceFilter(float tolerancePixels)
+{
+   SetTolerancePixels(tolerancePixels);
+}
+
+void RadialDistanceFilter::SetTolerancePixels(float tolerancePixels)
+{
+   if(tolerancePixels < 0)
+   {
+      throw std::out_of_range("tolerancePixels < 0");
+   }
+   _toleranceSq = tolerancePixels*tolerancePixels;
+}
+
+void RadialDistanceFilter::LineBegin(const CCPoint& point, double timestamp)
+{
+   _lastKept = point;
+}
+
+bool RadialDistanceFilter::Accept(const CCPoint& point, double timestamp)
+{
+   if(ccpDistanceSQ(point, _lastKept) <= _toleranceSq)
+   {
+      return false;
+   }
+   _lastKept = point;
+   return true;
+}
+
+// The squared distance from (px,py) to the segment (ax,ay)-(bx,by).
+static inline float SegmentDistanceSq(float px, float py, float ax, float ay, float bx, float by)
+{
+   float dx = bx - ax;
+   float dy = by - ay;
+   float lengthSq = dx*dx + dy*dy;
+   float t = 0;
+   if(lengthSq > 0)
+   {
+      t = clampf(((px - ax)*dx + (py - ay)*dy)/lengthSq, 0.0f, 1.0f);
+   }
+   float ex = ax + t*dx - px;
+   float ey = ay + t*dy - py;
+   return ex*ex + ey*ey;
+}
+
+uint32 LineSimplifier::RamerDouglasPeucker(const float32* x, const float32* y, uint32 count,
+                                           float tolerancePixels,
+                                           vector<uint8>& keep)
+{
+   keep.assign(count, 0);
+   if(count == 0)
+   {
+      return 0;
+   }
+   keep[0] = 1;
+   keep[count-1] = 1;
+   if(count < 3)
+   {
+      return count;
+   }
+   
+   const float toleranceSq = tolerancePixels*tolerancePixels;
+   uint32 kept = 2;
+   // Ranges (first,last) still to be checked.
+   vector<pair<uint32,uint32> > ranges;
+   ranges.push_back(make_pair(0u, count-1));
+   while(!ranges.empty())
+   {
+      uint32 first = ranges.back().first;
+      uint32 last = ranges.back().second;
+      ranges.pop_back();
+      
+      float maxDistSq = -1;
+      uint32 maxIdx = first;
+      for(uint32 idx = first+1; idx < last; idx++)
+      {
+         float distSq = SegmentDistanceSq(x[idx], y[idx], x[first], y[first], x[last], y[last]);
+         if(distSq > maxDistSq)
+         {
+            maxDistSq = distSq;
+            maxIdx = idx;
+         }
+      }
+      if(maxDistSq > toleranceSq)
+      {
+         keep[maxIdx] = 1;
+         kept++;
+         if(maxIdx - first > 1)
+         {
+            ranges.push_back(make_pair(first, maxIdx));
+         }
+         if(last - maxIdx > 1)
+         {
+            ranges.push_back(make_pair(maxIdx, last));
+         }
+      }
+   }
+   return kept;
+}
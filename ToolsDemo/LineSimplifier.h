@@ -0,0 +1,94 @@
+/********************************************************************
+ * File   : LineSimplifier.h
+ * Project: ToolsDemo
+ *
+ ********************************************************************
+ * Created on 10/19/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+#ifndef __ToolsDemo__LineSimplifier__
+#define __ToolsDemo__LineSimplifier__
+
+#include "CommonSTL.h"
+#include "CommonProject.h"
+
+/* Drops redundant input points before they reach the smoother.  Touch
+ * hardware reports samples at 60-120 Hz whether the finger moved or
+ * not, and every sample becomes a spline segment and a run of
+ * triangles.
+ *
+ * A LinePointFilter is plugged into a LineSmoother with
+ * LineSmoother::SetPointFilter(...).  It sees every LineContinue(...)
+ * point and decides whether to keep it.  The first and last points of
+ * a stroke are always kept.  Kept points keep their own timestamps, so
+ * the velocity of a kept point is measured over the real time since
+ * the previous kept point.
+ */
+class LinePointFilter
+{
+public:
+   // A new stroke starts at point.
+   virtual void LineBegin(const CCPoint& point, double timestamp) = 0;
+   // Return true to keep point.
+   virtual bool Accept(const CCPoint& point, double timestamp) = 0;
+   
+   virtual ~LinePointFilter() {}
+};
+
+/* The "radial distance" filter: a point is dropped if it is within
+ * tolerancePixels of the last point that was kept.  It costs one
+ * distance check per point.
+ */
+class RadialDistanceFilter : public LinePointFilter
+{
+private:
+   float _toleranceSq;
+   CCPoint _lastKept;
+   
+public:
+   RadialDistanceFilter(float tolerancePixels = 1.0f);
+   
+   void SetTolerancePixels(float tolerancePixels);
+   float GetTolerancePixels() const { return sqrtf(_toleranceSq); }
+   
+   virtual void LineBegin(const CCPoint& point, double timestamp);
+   virtual bool Accept(const CCPoint& point, double timestamp);
+};
+
+class LineSimplifier
+{
+public:
+   /* Ramer-Douglas-Peucker simplification of a whole polyline.
+    *
+    * keep[idx] is set to 1 for each point that must be kept so that no
+    * dropped point is further than tolerancePixels from the simplified
+    * line, and 0 for the others.  The first and last points are always
+    * kept.  Returns the number of points kept.
+    *
+    * It uses an explicit stack instead of recursion, so long strokes
+    * can't overflow the call stack.
+    */
+   static uint32 RamerDouglasPeucker(const float32* x, const float32* y, uint32 count,
+                                     float tolerancePixels,
+                                     vector<uint8>& keep);
+};
+
+#endif /* defined(__ToolsDemo__LineSimplifier__) */
@@ -25,6 +25,8 @@
  */
 
 #include "LineSmoother.h"
+#include "LineSimplifier.h"
+#include "WorkerPool.h"
 
 //#define DEBUG_LINE_SMOOTHER
 
@@ -32,6 +34,17 @@ const float PPS_MIN = 100.0f;
 const float PPS_MAX = 2000.0f;
 const float WIDTH_MIN = 0.1f;
 const float WIDTH_MAX = 30.0f;
+// Default VF_ONE_EURO parameters.
+const float ONE_EURO_MIN_CUTOFF_HZ = 1.0f;
+const float ONE_EURO_BETA = 0.0005f;
+const float ONE_EURO_DERIVATIVE_CUTOFF_HZ = 1.0f;
+// Streaming mode keeps this many original points (the Catmull-Rom
+// smoother reaches back 3 from the new point) and trims them when there
+// are twice as many, so the arrays never reallocate.
+const uint32 STREAM_ORIGINAL_POINTS = 4;
+// ...and keeps this many consumed smoothed points so the next batch
+// can be joined onto the last one.
+const uint32 STREAM_SMOOTHED_OVERLAP = 2;
 
 /* Calculate the Hermite Spline at a given value of t, where t is drawn from [0,1].
  * Outputs: Interpolated point.
@@ -42,14 +55,8 @@ const float WIDTH_MAX = 30.0f;
  */
 CCPoint LineSmoother::HermiteSpline(float t, CCPoint p0, CCPoint p1, CCPoint m0, CCPoint m1)
 {
-   float tSq = t*t;
-   float tCube = t*t*t;
-   CCPoint b0 = ccpMult(p0,2*tCube - 3*tSq + 1);
-   CCPoint b1 = ccpMult(m0,tCube - 2*tSq + t);
-   CCPoint b2 = ccpMult(p1,3*tSq - 2*tCube);
-   CCPoint b3 = ccpMult(m1,tCube - tSq);
-   
-   CCPoint result(b0.x+b1.x+b2.x+b3.x,b0.y+b1.y+b2.y+b3.y);
+   CCPoint result(SplineKernels::EvaluateAt(SplineKernels::HermiteCubic(p0.x, p1.x, m0.x, m1.x), t),
+                  SplineKernels::EvaluateAt(SplineKernels::HermiteCubic(p0.y, p1.y, m0.y, m1.y), t));
    /*
     if(t == 0.0)
     CCLOG("Smoothing new point set.");
@@ -74,11 +81,93 @@ void LineSmoother::ProcessNewPoint()
    }
    uint32 newPointIndex = _orgPoints.size()-1;
 #ifdef DEBUG_LINE_SMOOTHER
-   _orgPoints[newPointIndex].widthPixels = 1.0*newPointIndex;
+   _orgPoints.widthPixels[newPointIndex] = 1.0*GetStrokeIndex(newPointIndex);
 #endif
    CalculateVelocities(newPointIndex);
    CalculateWidths(newPointIndex);
    CalculateSmoothPoints(newPointIndex);
+   _smoothPoints.UpdateArcLength();
+   if(_streaming)
+   {
+      TrimOriginalPoints();
+   }
+}
+
+void LineSmoother::TrimOriginalPoints()
+{
+   if(_orgPoints.size() < 2*STREAM_ORIGINAL_POINTS)
+   {
+      return;
+   }
+   uint32 dropCount = _orgPoints.size() - STREAM_ORIGINAL_POINTS;
+   _orgPoints.erase_front(dropCount);
+   _orgPointsDropped += dropCount;
+}
+
+void LineSmoother::MarkLastSmoothPointIndex()
+{
+   if(_streaming && _smoothPoints.size() > STREAM_SMOOTHED_OVERLAP)
+   {
+      _smoothPoints.erase_front(_smoothPoints.size() - STREAM_SMOOTHED_OVERLAP);
+   }
+   _lastSmoothPointIndex = _smoothPoints.size()-1;
+}
+
+bool LineSmoother::GetSegment(uint32 newPointIndex, SEGMENT_T& segment) const
+{
+   return false;
+}
+
+uint32 LineSmoother::GetSegmentTicks(const SEGMENT_T& segment) const
+{
+   assert(segment.uniformTicks > 0);
+   if(_tessellationMode == TM_ADAPTIVE)
+   {
+      return MIN(segment.uniformTicks, SplineKernels::FlatnessSteps(segment.x, segment.y, _flatnessPixels));
+   }
+   return segment.uniformTicks;
+}
+
+void LineSmoother::EvaluateSegment(const SEGMENT_T& segment, uint32 ticks,
+                                   SMOOTHED_POINT_ARRAYS& output, uint32 first) const
+{
+   if(_tessellationMode == TM_ADAPTIVE)
+   {
+      SplineKernels::EvaluateForwardDifference(segment.x, segment.y, segment.width,
+                                               1.0f/ticks, ticks,
+                                               &output.x[first], &output.y[first], &output.widthPixels[first]);
+   }
+   else
+   {
+      SplineKernels::Evaluate(segment.x, segment.y, segment.width,
+                              1.0f/ticks, ticks,
+                              &output.x[first], &output.y[first], &output.widthPixels[first]);
+   }
+}
+
+uint32 LineSmoother::AddSmoothedSegment(const SEGMENT_T& segment)
+{
+   uint32 ticks = GetSegmentTicks(segment);
+   uint32 first = _smoothPoints.Extend(ticks, LP_CONTINUE);
+   EvaluateSegment(segment, ticks, _smoothPoints, first);
+   return first;
+}
+
+void LineSmoother::EndSmoothedLine(const SEGMENT_T& segment)
+{
+   _smoothPoints.push_back(SplineKernels::EvaluateAt(segment.x, 1.0f),
+                           SplineKernels::EvaluateAt(segment.y, 1.0f),
+                           SplineKernels::EvaluateAt(segment.width, 1.0f),
+                           LP_END);
+}
+
+void LineSmoother::SetFlatnessPixels(float flatnessPixels)
+{
+   if(flatnessPixels <= 0)
+   {
+      throw std::out_of_range("flatnessPixels <= 0");
+   }
+   _flatnessPixels = flatnessPixels;
 }
 
 // Given a new original point at newPointIndex, calculate a new
@@ -101,6 +190,13 @@ float Median(float a, float b, float c)
    return c;
 }
 
+// One-Euro smoothing factor for cutoffHz at a sample interval of dt seconds.
+static float OneEuroAlpha(float cutoffHz, float dt)
+{
+   float tau = 1.0f/(2.0f*M_PI*cutoffHz);
+   return 1.0f/(1.0f + tau/dt);
+}
+
 // Estimate the velocity of the new point relative to previous points
 // in points/second.
 void LineSmoother::CalculateVelocities(uint32 newPointIndex)
@@ -109,28 +205,49 @@ void LineSmoother::CalculateVelocities(uint32 newPointIndex)
    const float TS_MIN = 0.010f;  // 5 ms
    const float TS_MAX = 0.100f;  // 100 ms
    
-   if(newPointIndex < 3)
+   vector<float32>& pointsPerSecond = _orgPoints.pointsPerSecond;
+   
+   if(GetStrokeIndex(newPointIndex) < 3)
    {  // Must be the first couple of points.
-      _orgPoints[newPointIndex].pointsPerSecond = PPS_MIN;
+      pointsPerSecond[newPointIndex] = PPS_MIN;
+      _oneEuroVelocity = PPS_MIN;
+      _oneEuroDerivative = 0.0f;
    }
-   else
+   else if(_velocityFilter == VF_ONE_EURO)
    {
+      const uint32 i1 = newPointIndex-1;
+      const uint32 i2 = newPointIndex-0;
       
-      ORIGINAL_POINT& p0 = _orgPoints[newPointIndex-2];
-      ORIGINAL_POINT& p1 = _orgPoints[newPointIndex-1];
-      ORIGINAL_POINT& p2 = _orgPoints[newPointIndex-0];
+      float dx = _orgPoints.x[i2] - _orgPoints.x[i1];
+      float dy = _orgPoints.y[i2] - _orgPoints.y[i1];
+      float dist = sqrtf(dx*dx + dy*dy);
+      float dt = clampf(_orgPoints.timestamp[i2]-_orgPoints.timestamp[i1],TS_MIN,TS_MAX);
       
-      float dist = ccpDistance(p2.point, p1.point);
-      float dt = clampf(p2.timestamp-p1.timestamp,TS_MIN,TS_MAX);
+      float ppsRaw = dist/dt;
+      float derivativeRaw = (ppsRaw - _oneEuroVelocity)/dt;
+      _oneEuroDerivative += OneEuroAlpha(_oneEuroDerivativeCutoffHz, dt)*(derivativeRaw - _oneEuroDerivative);
+      float cutoffHz = _oneEuroMinCutoffHz + _oneEuroBeta*fabsf(_oneEuroDerivative);
+      _oneEuroVelocity += OneEuroAlpha(cutoffHz, dt)*(ppsRaw - _oneEuroVelocity);
+      pointsPerSecond[i2] = clampf(_oneEuroVelocity,PPS_MIN,PPS_MAX);
+   }
+   else
+   {
+      const uint32 i1 = newPointIndex-1;
+      const uint32 i2 = newPointIndex-0;
+      
+      float dx = _orgPoints.x[i2] - _orgPoints.x[i1];
+      float dy = _orgPoints.y[i2] - _orgPoints.y[i1];
+      float dist = sqrtf(dx*dx + dy*dy);
+      float dt = clampf(_orgPoints.timestamp[i2]-_orgPoints.timestamp[i1],TS_MIN,TS_MAX);
       
       float ppsRaw = clampf(dist/dt,PPS_MIN,PPS_MAX);
       // The velocity is the mostly the previous and some of the current point.
-      p2.pointsPerSecond = (ppsRaw + p1.pointsPerSecond + p0.pointsPerSecond)/3.0;
+      pointsPerSecond[i2] = (ppsRaw + pointsPerSecond[i1] + pointsPerSecond[i2-2])/3.0;
       // Round to the nearest 10 pps.
-      //      p2.pointsPerSecond = roundf(p2.pointsPerSecond/25)*25;
+      //      pointsPerSecond[i2] = roundf(pointsPerSecond[i2]/25)*25;
       /*
       CCLOG("PPS(final):%f, dist:%f, dt:%f ms, PPS(raw):%f, PPS(rawClamped):%f",
-            p2.pointsPerSecond,
+            pointsPerSecond[i2],
             dist,
             dt*1000,
             dist/dt,
@@ -143,9 +260,11 @@ void LineSmoother::CalculateVelocities(uint32 newPointIndex)
 void LineSmoother::CalculateWidths(uint32 newPointIndex)
 {
    
-   if(newPointIndex < 3)
+   vector<float32>& widthPixels = _orgPoints.widthPixels;
+   
+   if(GetStrokeIndex(newPointIndex) < 3)
    {
-      _orgPoints[newPointIndex].widthPixels = WIDTH_MIN;
+      widthPixels[newPointIndex] = WIDTH_MIN;
    }
    else
    {
@@ -153,14 +272,15 @@ void LineSmoother::CalculateWidths(uint32 newPointIndex)
       const float WIDTH_PPS_SLOPE = (WIDTH_MAX-WIDTH_MIN)/(PPS_MAX-PPS_MIN);
       const float WIDTH_PPS_OFFSET = WIDTH_MAX - WIDTH_PPS_SLOPE*PPS_MAX;
       
-      ORIGINAL_POINT& p0 = _orgPoints[newPointIndex-2];
-      ORIGINAL_POINT& p1 = _orgPoints[newPointIndex-1];
-      ORIGINAL_POINT& p2 = _orgPoints[newPointIndex-0];
-      
-      p2.widthPixels = (p2.pointsPerSecond*WIDTH_PPS_SLOPE + WIDTH_PPS_OFFSET +
-                        p1.widthPixels +
-                        p0.widthPixels)/3.0f;
-      //p2.widthPixels = roundf(p2.widthPixels);
+      if(_velocityFilter == VF_ONE_EURO)
+      {  // The velocity is already filtered.
+         widthPixels[newPointIndex] = _orgPoints.pointsPerSecond[newPointIndex]*WIDTH_PPS_SLOPE + WIDTH_PPS_OFFSET;
+         return;
+      }
+      widthPixels[newPointIndex] = (_orgPoints.pointsPerSecond[newPointIndex]*WIDTH_PPS_SLOPE + WIDTH_PPS_OFFSET +
+                                    widthPixels[newPointIndex-1] +
+                                    widthPixels[newPointIndex-2])/3.0f;
+      //widthPixels[newPointIndex] = roundf(widthPixels[newPointIndex]);
    }
 }
 
@@ -170,6 +290,15 @@ void LineSmoother::Reset()
    _orgPoints.clear();
    _smoothPoints.clear();
    _lastSmoothPointIndex = 0;
+   _orgPointsDropped = 0;
+}
+
+void LineSmoother::AddPoint(const CCPoint& point, double timestamp, LINE_POSITION_T position)
+{
+   ORIGINAL_POINT op;
+   op.Init(point, timestamp, position, ccp(0.0f,0.0f));
+   _orgPoints.push_back(op);
+   ProcessNewPoint();
 }
 
 void LineSmoother::LineBegin(const CCPoint& point, double timestamp)
@@ -177,10 +306,11 @@ void LineSmoother::LineBegin(const CCPoint& point, double timestamp)
    // Clear out all data when a new line begins.
    Reset();
    
-   ORIGINAL_POINT op;
-   op.Init(point, timestamp, LP_BEGIN, ccp(0.0f,0.0f));
-   _orgPoints.push_back(op);
-   ProcessNewPoint();
+   if(_pointFilter != NULL)
+   {
+      _pointFilter->LineBegin(point, timestamp);
+   }
+   AddPoint(point, timestamp, LP_BEGIN);
 }
 
 void LineSmoother::LineContinue(const CCPoint& point, double timestamp)
@@ -188,12 +318,13 @@ void LineSmoother::LineContinue(const CCPoint& point, double timestamp)
    // Verify we are in a line.  This means the last
    // point loaded cannot be the end.
    assert(_orgPoints.size() > 0 &&
-          _orgPoints[_orgPoints.size()-1].position != LP_END);
+          _orgPoints.position.back() != LP_END);
    
-   ORIGINAL_POINT op;
-   op.Init(point, timestamp, LP_CONTINUE, ccp(0.0f,0.0f));
-   _orgPoints.push_back(op);
-   ProcessNewPoint();
+   if(_pointFilter != NULL && !_pointFilter->Accept(point, timestamp))
+   {  // Redundant point.
+      return;
+   }
+   AddPoint(point, timestamp, LP_CONTINUE);
 }
 
 
@@ -204,12 +335,9 @@ void LineSmoother::LineEnd(const CCPoint& point, double timestamp)
    // a 2-point line here, which will may throw off the
    // smoothing algorithm.
    assert(_orgPoints.size() > 0 &&
-          _orgPoints[_orgPoints.size()-1].position != LP_END);
-   ORIGINAL_POINT op;
-      
-   op.Init(point, timestamp, LP_END, ccp(0.0f,0.0f));
-   _orgPoints.push_back(op);
-   ProcessNewPoint();
+          _orgPoints.position.back() != LP_END);
+   // The end point is always kept.
+   AddPoint(point, timestamp, LP_END);
 #ifdef DEBUG_LINE_SMOOTHER
    // Dump the original point data for the line.
    CCLOG("--------------------------------------------------");
@@ -226,7 +354,300 @@ void LineSmoother::LineEnd(const CCPoint& point, double timestamp)
 #endif
 }
 
-LineSmoother::LineSmoother()
+// Segments are handed to the workers in chunks of at least this many,
+// so the threads aren't fighting over the counter for tiny jobs.
+const uint32 BATCH_MIN_SEGMENTS_PER_CHUNK = 256;
+
+void LineSmoother::BatchBuildSegments(void* job, uint32 chunk)
+{
+   BATCH_JOB_T* batchJob = (BATCH_JOB_T*)job;
+   LineSmoother* smoother = batchJob->smoother;
+   uint32 start = chunk*batchJob->segmentsPerChunk;
+   uint32 end = MIN(start + batchJob->segmentsPerChunk, batchJob->segmentCount);
+   for(uint32 idx = start; idx < end; idx++)
+   {
+      SEGMENT_T& segment = smoother->_batchSegments[idx];
+      // Segment idx is added by original point idx+2.
+      if(smoother->GetSegment(idx+2, segment))
+      {
+         smoother->_batchFirstPoint[idx] = smoother->GetSegmentTicks(segment);
+      }
+      else
+      {
+         smoother->_batchFirstPoint[idx] = 0;
+      }
+   }
+}
+
+void LineSmoother::BatchEvaluateSegments(void* job, uint32 chunk)
+{
+   BATCH_JOB_T* batchJob = (BATCH_JOB_T*)job;
+   const LineSmoother* smoother = batchJob->smoother;
+   uint32 start = chunk*batchJob->segmentsPerChunk;
+   uint32 end = MIN(start + batchJob->segmentsPerChunk, batchJob->segmentCount);
+   for(uint32 idx = start; idx < end; idx++)
+   {
+      uint32 first = smoother->_batchFirstPoint[idx];
+      uint32 ticks = smoother->_batchFirstPoint[idx+1] - first;
+      if(ticks > 0)
+      {
+         smoother->EvaluateSegment(smoother->_batchSegments[idx], ticks, *batchJob->output, first);
+      }
+   }
+}
+
+void LineSmoother::SmoothAll(const CCPoint* points, const double* timestamps, uint32 count,
+                             SMOOTHED_POINT_ARRAYS& output,
+                             WorkerPool* workers)
+{
+   Reset();
+   output.clear();
+   if(count == 0)
+   {
+      return;
+   }
+   if(points == NULL || timestamps == NULL)
+   {
+      throw std::out_of_range("points == NULL || timestamps == NULL");
+   }
+   
+   // Load the stroke and work out the velocities and widths in a single
+   // pass.  Each point depends on the ones before it, so this part can't
+   // be split up (but it is cheap next to the tessellation).
+   _orgPoints.x.resize(count);
+   _orgPoints.y.resize(count);
+   for(uint32 idx = 0; idx < count; idx++)
+   {
+      _orgPoints.x[idx] = points[idx].x;
+      _orgPoints.y[idx] = points[idx].y;
+   }
+   _orgPoints.timestamp.assign(timestamps, timestamps+count);
+   if(_endSimplifyPixels > 0)
+   {
+      count = SimplifyStroke();
+   }
+   _orgPoints.position.assign(count, LP_CONTINUE);
+   _orgPoints.tangentX.assign(count, 0.0f);
+   _orgPoints.tangentY.assign(count, 0.0f);
+   _orgPoints.pointsPerSecond.assign(count, 1.0f);
+   _orgPoints.widthPixels.assign(count, 1.0f);
+   _orgPoints.position[0] = LP_BEGIN;
+   if(count > 1)
+   {
+      _orgPoints.position[count-1] = LP_END;
+   }
+   for(uint32 idx = 0; idx < count; idx++)
+   {
+#ifdef DEBUG_LINE_SMOOTHER
+      _orgPoints.widthPixels[idx] = 1.0*idx;
+#endif
+      CalculateVelocities(idx);
+      CalculateWidths(idx);
+   }
+   if(count < 3)
+   {  // The smoothers need 3 points before they add anything.
+      return;
+   }
+   
+   // Build and size every segment, then lay them out in output.
+   BATCH_JOB_T job;
+   job.smoother = this;
+   job.output = &output;
+   job.segmentCount = count-2;
+   uint32 chunks = 1;
+   if(workers != NULL && workers->GetThreadCount() > 0)
+   {
+      chunks = MIN(4*(workers->GetThreadCount()+1),
+                   (job.segmentCount + BATCH_MIN_SEGMENTS_PER_CHUNK - 1)/BATCH_MIN_SEGMENTS_PER_CHUNK);
+      chunks = MAX(chunks, 1);
+   }
+   job.segmentsPerChunk = (job.segmentCount + chunks - 1)/chunks;
+   _batchSegments.resize(job.segmentCount);
+   _batchFirstPoint.resize(job.segmentCount+1);
+   if(workers != NULL)
+   {
+      workers->ParallelFor(chunks, BatchBuildSegments, &job);
+   }
+   else
+   {
+      BatchBuildSegments(&job, 0);
+   }
+   // Turn the tick counts into the index of each segment's first point.
+   uint32 total = 0;
+   for(uint32 idx = 0; idx < job.segmentCount; idx++)
+   {
+      uint32 ticks = _batchFirstPoint[idx];
+      _batchFirstPoint[idx] = total;
+      total += ticks;
+   }
+   _batchFirstPoint[job.segmentCount] = total;
+   if(total == 0)
+   {
+      return;
+   }
+   // One more for the t = 1 point of the last segment (see
+   // EndSmoothedLine(...)).
+   const SEGMENT_T& lastSegment = _batchSegments[job.segmentCount-1];
+   const bool ended = (_batchFirstPoint[job.segmentCount-1] < total);
+   output.Extend(ended ? total+1 : total, LP_CONTINUE);
+   if(workers != NULL)
+   {
+      workers->ParallelFor(chunks, BatchEvaluateSegments, &job);
+   }
+   else
+   {
+      BatchEvaluateSegments(&job, 0);
+   }
+   output.position[0] = LP_BEGIN;
+   if(ended)
+   {
+      output.x[total] = SplineKernels::EvaluateAt(lastSegment.x, 1.0f);
+      output.y[total] = SplineKernels::EvaluateAt(lastSegment.y, 1.0f);
+      output.widthPixels[total] = SplineKernels::EvaluateAt(lastSegment.width, 1.0f);
+      output.position[total] = LP_END;
+   }
+   else
+   {
+      output.position[total-1] = LP_END;
+   }
+   output.UpdateArcLength();
+}
+
+void LineSmoother::ResampleUniform(const SMOOTHED_POINT_ARRAYS& line,
+                                   float spacingPixels,
+                                   float& distance,
+                                   SMOOTHED_POINT_ARRAYS& output)
+{
+   if(spacingPixels <= 0.0f)
+   {
+      throw std::out_of_range("spacingPixels <= 0");
+   }
+   if(line.empty())
+   {
+      return;
+   }
+   const vector<float32>& arcLength = line.arcLength;
+   const uint32 lastIdx = line.size()-1;
+   const float32 total = arcLength[lastIdx];
+   const bool ended = (line.Position(lastIdx) == LP_END);
+   
+   // Streaming mode may have dropped the points before distance.
+   distance = MAX(distance, arcLength[0]);
+   uint32 idx = line.FindArcLength(distance);
+   while(distance <= total)
+   {
+      while(idx < lastIdx && arcLength[idx+1] < distance)
+      {
+         idx++;
+      }
+      float32 x = line.x[idx];
+      float32 y = line.y[idx];
+      float32 width = line.widthPixels[idx];
+      if(idx < lastIdx)
+      {
+         float32 length = arcLength[idx+1] - arcLength[idx];
+         if(length > 0.0f)
+         {
+            float32 t = (distance - arcLength[idx])/length;
+            x += t*(line.x[idx+1] - x);
+            y += t*(line.y[idx+1] - y);
+            width += t*(line.widthPixels[idx+1] - width);
+         }
+      }
+      LINE_POSITION_T position = LP_CONTINUE;
+      if(distance == 0.0f && line.Position(0) == LP_BEGIN)
+      {
+         position = LP_BEGIN;
+      }
+      else if(ended && distance == total)
+      {
+         position = LP_END;
+      }
+      output.push_back(x, y, width, position);
+      distance += spacingPixels;
+   }
+   if(ended && distance < total + spacingPixels)
+   {  // The end did not land on the spacing.
+      output.push_back(line.x[lastIdx], line.y[lastIdx], line.widthPixels[lastIdx], LP_END);
+      distance = total + spacingPixels;
+   }
+}
+
+uint32 LineSmoother::SimplifyStroke()
+{
+   uint32 count = _orgPoints.x.size();
+   uint32 kept = LineSimplifier::RamerDouglasPeucker(&_orgPoints.x[0], &_orgPoints.y[0], count,
+                                                     _endSimplifyPixels, _simplifyKeep);
+   if(kept == count)
+   {
+      return count;
+   }
+   // Close up the gaps.  The kept points keep their own timestamps.
+   uint32 next = 0;
+   for(uint32 idx = 0; idx < count; idx++)
+   {
+      if(_simplifyKeep[idx])
+      {
+         _orgPoints.x[next] = _orgPoints.x[idx];
+         _orgPoints.y[next] = _orgPoints.y[idx];
+         _orgPoints.timestamp[next] = _orgPoints.timestamp[idx];
+         next++;
+      }
+   }
+   assert(next == kept);
+   _orgPoints.x.resize(kept);
+   _orgPoints.y.resize(kept);
+   _orgPoints.timestamp.resize(kept);
+   return kept;
+}
+
+void LineSmoother::SetPointFilter(LinePointFilter* pointFilter)
+{
+   if(pointFilter != _pointFilter)
+   {
+      delete _pointFilter;
+      _pointFilter = pointFilter;
+   }
+}
+
+void LineSmoother::SetEndSimplifyPixels(float endSimplifyPixels)
+{
+   if(endSimplifyPixels < 0)
+   {
+      throw std::out_of_range("endSimplifyPixels < 0");
+   }
+   _endSimplifyPixels = endSimplifyPixels;
+}
+
+void LineSmoother::SetOneEuroParameters(float minCutoffHz, float beta, float derivativeCutoffHz)
+{
+   if(minCutoffHz <= 0 || derivativeCutoffHz <= 0)
+   {
+      throw std::out_of_range("cutoffHz <= 0");
+   }
+   if(beta < 0)
+   {
+      throw std::out_of_range("beta < 0");
+   }
+   _oneEuroMinCutoffHz = minCutoffHz;
+   _oneEuroBeta = beta;
+   _oneEuroDerivativeCutoffHz = derivativeCutoffHz;
+}
+
+LineSmoother::LineSmoother() :
+   _lastSmoothPointIndex(0),
+   _tessellationMode(TM_UNIFORM),
+   _flatnessPixels(0.25f),
+   _velocityFilter(VF_BOX),
+   _oneEuroMinCutoffHz(ONE_EURO_MIN_CUTOFF_HZ),
+   _oneEuroBeta(ONE_EURO_BETA),
+   _oneEuroDerivativeCutoffHz(ONE_EURO_DERIVATIVE_CUTOFF_HZ),
+   _oneEuroVelocity(PPS_MIN),
+   _oneEuroDerivative(0.0f),
+   _streaming(false),
+   _orgPointsDropped(0),
+   _pointFilter(NULL),
+   _endSimplifyPixels(0.0f)
 {
    
 }
@@ -234,4 +655,5 @@ LineSmoother::LineSmoother()
 LineSmoother::~LineSmoother()
 {
    Reset();
+   delete _pointFilter;
 }
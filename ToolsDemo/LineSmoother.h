@@ -29,6 +29,10 @@
 
 #include "CommonProject.h"
 #include "CommonSTL.h"
+#include "SplineKernels.h"
+
+class LinePointFilter;
+class WorkerPool;
 
 class LineSmoother
 {
@@ -41,6 +45,39 @@ public:
       LP_END,
       LP_MAX
    } LINE_POSITION_T;
+   
+   // How each curve segment is broken into smoothed points.
+   //
+   // TM_UNIFORM  - one point every couple of pixels along the chord,
+   //               evaluated with the SIMD kernels.
+   // TM_ADAPTIVE - only as many points as the curvature of the segment
+   //               needs to stay within the flatness tolerance (never
+   //               more than TM_UNIFORM), evaluated by forward
+   //               differencing.  Gentle segments of long fast strokes
+   //               produce far fewer points.
+   typedef enum
+   {
+      TM_UNIFORM = 0,
+      TM_ADAPTIVE,
+      TM_MAX
+   } TESSELLATION_MODE_T;
+   
+   // How the velocity (and from it, the width) of each point is smoothed.
+   //
+   // VF_BOX      - the average of the last three values.  Cheap, but the
+   //               width lags behind when the stroke speeds up or slows
+   //               down quickly.
+   // VF_ONE_EURO - a One-Euro filter: a low pass filter whose cutoff
+   //               rises with the rate the velocity is changing.  Slow,
+   //               steady strokes get a smooth width; fast changes come
+   //               through with little lag.  The width follows the
+   //               filtered velocity directly.
+   typedef enum
+   {
+      VF_BOX = 0,
+      VF_ONE_EURO,
+      VF_MAX
+   } VELOCITY_FILTER_T;
       
    struct SMOOTHED_POINT
    {
@@ -102,18 +139,266 @@ public:
       }
    };
    
+   /* The points are stored as one array per field ("structure of arrays")
+    * instead of a vector of ORIGINAL_POINT/SMOOTHED_POINT.  Each of the
+    * calculations only touches a few of the fields, so they stream through
+    * contiguous floats instead of dragging every field of every point 
+    * through the cache.
+    *
+    * For code that wants the old point structures, size(), operator[] and
+    * back() work like they do on a vector, except they return a copy.
+    */
+   class ORIGINAL_POINT_ARRAYS
+   {
+   public:
+      vector<float32> x;
+      vector<float32> y;
+      vector<double> timestamp;
+      vector<uint8> position;
+      vector<float32> tangentX;
+      vector<float32> tangentY;
+      vector<float32> pointsPerSecond;
+      vector<float32> widthPixels;
+      
+      uint32 size() const { return x.size(); }
+      bool empty() const { return x.empty(); }
+      CCPoint Point(uint32 idx) const { return ccp(x[idx],y[idx]); }
+      LINE_POSITION_T Position(uint32 idx) const { return (LINE_POSITION_T)position[idx]; }
+      
+      void clear()
+      {
+         x.clear();
+         y.clear();
+         timestamp.clear();
+         position.clear();
+         tangentX.clear();
+         tangentY.clear();
+         pointsPerSecond.clear();
+         widthPixels.clear();
+      }
+      
+      // Remove the first count points (used by streaming mode).
+      void erase_front(uint32 count)
+      {
+         x.erase(x.begin(), x.begin()+count);
+         y.erase(y.begin(), y.begin()+count);
+         timestamp.erase(timestamp.begin(), timestamp.begin()+count);
+         position.erase(position.begin(), position.begin()+count);
+         tangentX.erase(tangentX.begin(), tangentX.begin()+count);
+         tangentY.erase(tangentY.begin(), tangentY.begin()+count);
+         pointsPerSecond.erase(pointsPerSecond.begin(), pointsPerSecond.begin()+count);
+         widthPixels.erase(widthPixels.begin(), widthPixels.begin()+count);
+      }
+      
+      void push_back(const ORIGINAL_POINT& op)
+      {
+         x.push_back(op.point.x);
+         y.push_back(op.point.y);
+         timestamp.push_back(op.timestamp);
+         position.push_back(op.position);
+         tangentX.push_back(op.tangent.x);
+         tangentY.push_back(op.tangent.y);
+         pointsPerSecond.push_back(op.pointsPerSecond);
+         widthPixels.push_back(op.widthPixels);
+      }
+      
+      ORIGINAL_POINT operator[](uint32 idx) const
+      {
+         ORIGINAL_POINT op;
+         op.Init(Point(idx), timestamp[idx], Position(idx), ccp(tangentX[idx],tangentY[idx]));
+         op.pointsPerSecond = pointsPerSecond[idx];
+         op.widthPixels = widthPixels[idx];
+         return op;
+      }
+      ORIGINAL_POINT back() const { return (*this)[size()-1]; }
+   };
+   
+   /* arcLength[idx] is the distance (in pixels) along the smoothed line
+    * from the start of the stroke to point idx.  It is filled in by
+    * UpdateArcLength(), which only does the points added since it was
+    * last called, so it can run after every new segment.  The other
+    * methods do not touch it, so it can be shorter than the others
+    * until UpdateArcLength() is called.
+    */
+   class SMOOTHED_POINT_ARRAYS
+   {
+   public:
+      vector<float32> x;
+      vector<float32> y;
+      vector<float32> widthPixels;
+      vector<uint8> position;
+      vector<float32> arcLength;
+      
+      uint32 size() const { return x.size(); }
+      bool empty() const { return x.empty(); }
+      CCPoint Point(uint32 idx) const { return ccp(x[idx],y[idx]); }
+      LINE_POSITION_T Position(uint32 idx) const { return (LINE_POSITION_T)position[idx]; }
+      
+      void clear()
+      {
+         x.clear();
+         y.clear();
+         widthPixels.clear();
+         position.clear();
+         arcLength.clear();
+      }
+      
+      // Remove the first count points (used by streaming mode).  Call
+      // UpdateArcLength() first so the distances carry on from the
+      // points that are left.
+      void erase_front(uint32 count)
+      {
+         x.erase(x.begin(), x.begin()+count);
+         y.erase(y.begin(), y.begin()+count);
+         widthPixels.erase(widthPixels.begin(), widthPixels.begin()+count);
+         position.erase(position.begin(), position.begin()+count);
+         arcLength.erase(arcLength.begin(), arcLength.begin()+MIN(count, arcLength.size()));
+      }
+      
+      void UpdateArcLength()
+      {
+         uint32 idx = arcLength.size();
+         if(idx >= size())
+         {
+            return;
+         }
+         arcLength.resize(size());
+         if(idx == 0)
+         {
+            arcLength[0] = 0.0f;
+            idx = 1;
+         }
+         for(; idx < size(); idx++)
+         {
+            float32 dx = x[idx]-x[idx-1];
+            float32 dy = y[idx]-y[idx-1];
+            arcLength[idx] = arcLength[idx-1] + sqrtf(dx*dx + dy*dy);
+         }
+      }
+      
+      // The index of the last point at or before distance along the line
+      // (a binary search of arcLength).  The arc lengths must be up to date.
+      uint32 FindArcLength(float32 distance) const
+      {
+         assert(arcLength.size() == size());
+         vector<float32>::const_iterator iter = upper_bound(arcLength.begin(), arcLength.end(), distance);
+         if(iter == arcLength.begin())
+         {
+            return 0;
+         }
+         return (iter - arcLength.begin()) - 1;
+      }
+      
+      void push_back(float32 x_, float32 y_, float32 widthPixels_, LINE_POSITION_T position_)
+      {
+         x.push_back(x_);
+         y.push_back(y_);
+         widthPixels.push_back(widthPixels_);
+         position.push_back(position_);
+      }
+      void push_back(const SMOOTHED_POINT& sm) { push_back(sm.point.x, sm.point.y, sm.widthPixels, sm.position); }
+      
+      // Grow every array by count points (all at position_) and return
+      // the index of the first new one, so a whole segment can be
+      // written in place instead of pushed one point at a time.
+      uint32 Extend(uint32 count, LINE_POSITION_T position_)
+      {
+         uint32 first = size();
+         x.resize(first+count);
+         y.resize(first+count);
+         widthPixels.resize(first+count);
+         position.resize(first+count, position_);
+         return first;
+      }
+      
+      SMOOTHED_POINT operator[](uint32 idx) const
+      {
+         SMOOTHED_POINT sm;
+         sm.point = Point(idx);
+         sm.position = Position(idx);
+         sm.widthPixels = widthPixels[idx];
+         return sm;
+      }
+      SMOOTHED_POINT back() const { return (*this)[size()-1]; }
+   };
+   
+protected:
+   // One curve segment: a cubic for each of x, y and width over
+   // t = [0,1], and the point count used in TM_UNIFORM mode (the most
+   // used in TM_ADAPTIVE mode).
+   typedef struct
+   {
+      SplineKernels::CUBIC_T x;
+      SplineKernels::CUBIC_T y;
+      SplineKernels::CUBIC_T width;
+      uint32 uniformTicks;
+   } SEGMENT_T;
+   
 private:
    // ALL the point for this line accumulated.
-   vector<ORIGINAL_POINT> _orgPoints;
+   ORIGINAL_POINT_ARRAYS _orgPoints;
    
    // The smoothed points created for this line.
-   vector<SMOOTHED_POINT> _smoothPoints;
+   SMOOTHED_POINT_ARRAYS _smoothPoints;
    
    // Keeps the index of the last smoothed index point
    // retrieved for a client so they can pick up where
    // they left off when  drawing a single group at a time.
    uint32 _lastSmoothPointIndex;
    
+   TESSELLATION_MODE_T _tessellationMode;
+   float _flatnessPixels;
+   
+   VELOCITY_FILTER_T _velocityFilter;
+   float _oneEuroMinCutoffHz;
+   float _oneEuroBeta;
+   float _oneEuroDerivativeCutoffHz;
+   // The One-Euro filter state: the filtered velocity (before it is
+   // clamped) and its filtered rate of change.
+   float _oneEuroVelocity;
+   float _oneEuroDerivative;
+   
+   // Streaming mode only keeps a small window of the stroke (see
+   // SetStreaming(...)).  This is how many original points have been
+   // dropped off the front of _orgPoints since the stroke began.
+   bool _streaming;
+   uint32 _orgPointsDropped;
+   
+   // Drop the original points the smoothers will not look at again.
+   void TrimOriginalPoints();
+   
+   // Optional filter for incoming points (owned), and the tolerance
+   // for the Ramer-Douglas-Peucker pass in SmoothAll(...) (0 for none).
+   LinePointFilter* _pointFilter;
+   float _endSimplifyPixels;
+   vector<uint8> _simplifyKeep;
+   
+   // Scratch space for SmoothAll(...), kept so it gets reused.
+   vector<SEGMENT_T> _batchSegments;
+   vector<uint32> _batchFirstPoint;
+   
+   // Point count for a segment in the current tessellation mode.
+   uint32 GetSegmentTicks(const SEGMENT_T& segment) const;
+   // Write the segment's ticks points into output starting at first.
+   void EvaluateSegment(const SEGMENT_T& segment, uint32 ticks,
+                        SMOOTHED_POINT_ARRAYS& output, uint32 first) const;
+   // The two parallel passes of SmoothAll(...).
+   typedef struct
+   {
+      LineSmoother* smoother;
+      SMOOTHED_POINT_ARRAYS* output;
+      uint32 segmentsPerChunk;
+      uint32 segmentCount;
+   } BATCH_JOB_T;
+   static void BatchBuildSegments(void* job, uint32 chunk);
+   static void BatchEvaluateSegments(void* job, uint32 chunk);
+   
+   // Add an original point and run the smoothing chain on it.
+   void AddPoint(const CCPoint& point, double timestamp, LINE_POSITION_T position);
+   // Run RDP over the x, y and timestamps SmoothAll(...) has loaded
+   // and drop the points it doesn't keep.  Returns the number left.
+   uint32 SimplifyStroke();
+   
    // Called each time a new point original is added.
    // This method is overriden in derived classes to add
    // new types of spline options.
@@ -148,11 +433,33 @@ protected:
    virtual void CalculateWidths(uint32 newPointIndex);
    
    // Methods used by derived classes to implement ProcessNewPoint
-   vector<ORIGINAL_POINT>& GetOriginalPoints() { return _orgPoints; }
-   vector<SMOOTHED_POINT>& GetSmoothedPoints() { return _smoothPoints; }
+   // The position of _orgPoints[pointIndex] in the whole stroke (0 is the
+   // LineBegin(...) point).  This is the same as pointIndex unless
+   // streaming mode has dropped points off the front.
+   uint32 GetStrokeIndex(uint32 pointIndex) const { return pointIndex + _orgPointsDropped; }
+   ORIGINAL_POINT_ARRAYS& GetOriginalPoints() { return _orgPoints; }
+   SMOOTHED_POINT_ARRAYS& GetSmoothedPoints() { return _smoothPoints; }
    void AddSmoothedPoint(const SMOOTHED_POINT& sm) { _smoothPoints.push_back(sm); }
    CCPoint HermiteSpline(float t, CCPoint p0, CCPoint p1, CCPoint m0, CCPoint m1);
 
+   // Describe the segment that is added when the original point at
+   // newPointIndex arrives, or return false if none is.  The velocities
+   // and widths of the points up to newPointIndex have been calculated.
+   //
+   // SmoothAll(...) calls this for many points at once from several
+   // threads, so it must only read.  Derived classes implement it and
+   // usually call it from CalculateSmoothPoints(...) too, so both paths
+   // produce the same curve.
+   virtual bool GetSegment(uint32 newPointIndex, SEGMENT_T& segment) const;
+   
+   // Append a segment to the smoothed points and return the index of its
+   // first point.
+   uint32 AddSmoothedSegment(const SEGMENT_T& segment);
+   // Segments stop short of t = 1, where the next one starts.  The last
+   // segment of a line has no next one, so this adds its t = 1 point
+   // as the LP_END point.
+   void EndSmoothedLine(const SEGMENT_T& segment);
+
    
 public:
    // Resets the data points.
@@ -168,17 +475,110 @@ public:
    LineSmoother();
    virtual ~LineSmoother();
    
+   void SetTessellationMode(TESSELLATION_MODE_T tessellationMode) { _tessellationMode = tessellationMode; }
+   TESSELLATION_MODE_T GetTessellationMode() const { return _tessellationMode; }
+   // The furthest (in pixels) the smoothed polyline may stray from the
+   // curve in TM_ADAPTIVE mode.
+   void SetFlatnessPixels(float flatnessPixels);
+   float GetFlatnessPixels() const { return _flatnessPixels; }
+   
+   // Change these between strokes, not during one.
+   void SetVelocityFilter(VELOCITY_FILTER_T velocityFilter) { _velocityFilter = velocityFilter; }
+   VELOCITY_FILTER_T GetVelocityFilter() const { return _velocityFilter; }
+   // The VF_ONE_EURO parameters.  The cutoff is
+   //    minCutoffHz + beta*|rate of change of the velocity|
+   // where the rate of change is itself low pass filtered at
+   // derivativeCutoffHz.  Lower minCutoffHz for less jitter in slow
+   // strokes, raise beta for less lag in fast ones.
+   void SetOneEuroParameters(float minCutoffHz, float beta, float derivativeCutoffHz);
+   float GetOneEuroMinCutoffHz() const { return _oneEuroMinCutoffHz; }
+   float GetOneEuroBeta() const { return _oneEuroBeta; }
+   float GetOneEuroDerivativeCutoffHz() const { return _oneEuroDerivativeCutoffHz; }
+   
+   // In streaming mode the memory used by a stroke stays the same no
+   // matter how long it is:
+   //
+   // - Only the last few original points (all the smoothers ever look
+   //   at) are kept.  GetOriginalPointsConst() returns just that window.
+   // - MarkLastSmoothPointIndex() drops the smoothed points the caller
+   //   has already consumed, except the last two, which AddSmoothedPoints
+   //   style consumers re-read to join the next batch onto the last one.
+   //
+   // So the caller must consume the new smoothed points (from
+   // GetLastSmoothPointIndex() on) and call MarkLastSmoothPointIndex()
+   // after each new point, the way MainScene does.
+   void SetStreaming(bool streaming) { _streaming = streaming; }
+   bool IsStreaming() const { return _streaming; }
+   
+   // Plug in a filter that drops redundant LineContinue(...) points
+   // before they are smoothed (see LineSimplifier.h).  The smoother
+   // takes ownership of the filter and deletes it.  NULL removes it.
+   void SetPointFilter(LinePointFilter* pointFilter);
+   LinePointFilter* GetPointFilter() const { return _pointFilter; }
+   
+   // If > 0, SmoothAll(...) runs a Ramer-Douglas-Peucker pass with this
+   // tolerance over the stroke first, and only smooths the points it
+   // keeps.  This is meant for strokes that are recorded or replayed.
+   // LineBegin/LineContinue/LineEnd ignore it: their smoothed points may
+   // already be drawn by the time the stroke ends.
+   void SetEndSimplifyPixels(float endSimplifyPixels);
+   float GetEndSimplifyPixels() const { return _endSimplifyPixels; }
+   
+   // Smooth a whole recorded stroke in one go, instead of feeding it
+   // through LineBegin/LineContinue/LineEnd.  The result is the same
+   // smoothed points those calls would produce (without the point
+   // filter), written to output.  If SetEndSimplifyPixels(...) is on,
+   // the stroke is simplified first.
+   //
+   // The velocities and widths are worked out in one pass over the
+   // points (each depends on the ones before).  Then every segment is
+   // built and sized, output is resized once, and the segments are
+   // evaluated straight into it.  If workers is given, the segments are
+   // split into chunks (at segment boundaries) that are built and
+   // evaluated on the worker threads.
+   //
+   // Afterwards GetOriginalPointsConst() holds the stroke's original
+   // points; the smoother's own smoothed points are left empty.
+   void SmoothAll(const CCPoint* points, const double* timestamps, uint32 count,
+                  SMOOTHED_POINT_ARRAYS& output,
+                  WorkerPool* workers = NULL);
+   
 
 public:
    // Use this to retrieve the original set of points.  This can be useful for debugging
    // or if you wish to redraw the entire set (i.e. copy, reset, and resubmit them).
-   const vector<ORIGINAL_POINT>& GetOriginalPointsConst() const { return _orgPoints; }
+   const ORIGINAL_POINT_ARRAYS& GetOriginalPointsConst() const { return _orgPoints; }
    // New smoothed points are added to this array.  You can use the points in the original
    // data to line up the positions of the points in this array.  When a new line is started
    // both arrays are cleared.
-   const vector<SMOOTHED_POINT>& GetSmoothedPointsConst() const { return _smoothPoints; }
-   void MarkLastSmoothPointIndex() { _lastSmoothPointIndex = _smoothPoints.size()-1; }
+   const SMOOTHED_POINT_ARRAYS& GetSmoothedPointsConst() const { return _smoothPoints; }
+   void MarkLastSmoothPointIndex();
    uint32 GetLastSmoothPointIndex() { return _lastSmoothPointIndex; }
+   
+   // Walk along line from distance (in pixels from the start of the
+   // stroke) and append a point every spacingPixels to output, with the
+   // position and width interpolated from the smoothed points.  It stops
+   // at the end of line, and leaves distance where the next point would
+   // go, so calling it again after more points arrive carries on with
+   // the same spacing.  This is linear in the number of points.
+   //
+   // The point at distance 0 is LP_BEGIN.  Once line has ended, its
+   // last point is appended as LP_END (so the last gap is usually
+   // shorter).  The arc lengths of the points appended to output are not
+   // filled in.
+   //
+   // In streaming mode call this before MarkLastSmoothPointIndex(),
+   // which drops the points it needs.
+   static void ResampleUniform(const SMOOTHED_POINT_ARRAYS& line,
+                               float spacingPixels,
+                               float& distance,
+                               SMOOTHED_POINT_ARRAYS& output);
+   void ResampleUniform(float spacingPixels, float& distance, SMOOTHED_POINT_ARRAYS& output) const
+   {
+      ResampleUniform(_smoothPoints, spacingPixels, distance, output);
+   }
+   // The length of the smoothed line so far.
+   float GetArcLength() const { return _smoothPoints.arcLength.empty() ? 0.0f : _smoothPoints.arcLength.back(); }
 };
 
 #endif /* defined(__ToolsDemo__LineSmoother__) */
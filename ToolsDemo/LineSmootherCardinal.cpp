@@ -25,7 +25,7 @@
  */
 
 #include "LineSmootherCardinal.h"
-#include "MathUtilities.h"
+#include "SplineKernels.h"
 
 
 LineSmootherCardinal::LineSmootherCardinal() :
@@ -34,73 +34,90 @@ LineSmootherCardinal::LineSmootherCardinal() :
    
 }
 
-void LineSmootherCardinal::CalculateSmoothPoints(uint32 newPointIndex)
+bool LineSmootherCardinal::GetSegment(uint32 newPointIndex, SEGMENT_T& segment) const
 {
-   vector<ORIGINAL_POINT>& orgPoints = GetOriginalPoints();
-   vector<SMOOTHED_POINT>& smoothPoints = GetSmoothedPoints();
+   const ORIGINAL_POINT_ARRAYS& orgPoints = GetOriginalPointsConst();
    
-   if(orgPoints.size() < 3)
+   if(newPointIndex < 2 || GetStrokeIndex(newPointIndex) < 2)
    {  // Nothing to do with a single point.
-      return;
+      return false;
    }
-   ORIGINAL_POINT& p2 = orgPoints[newPointIndex];
-   ORIGINAL_POINT& p1 = orgPoints[newPointIndex-1];
-   ORIGINAL_POINT& p0 = orgPoints[newPointIndex-2];
+   const uint32 i2 = newPointIndex;
+   const uint32 i1 = newPointIndex-1;
+   const uint32 i0 = newPointIndex-2;
+   const vector<float32>& x = orgPoints.x;
+   const vector<float32>& y = orgPoints.y;
+   const vector<float32>& width = orgPoints.widthPixels;
    
-   if(p0.position == LP_BEGIN)
-   {  // Estimate the tangent for the start point of this new
-      // line.
-      p0.tangent.x = p1.point.x-p0.point.x;
-      p0.tangent.y = p1.point.y-p0.point.y;
+   // The tangent at the start point of the line is estimated from the
+   // first two points.  The others use the points on either side.  These
+   // are the same values CalculateSmoothPoints(...) leaves in tangentX/Y.
+   float32 m0x;
+   float32 m0y;
+   if(orgPoints.position[i0] == LP_BEGIN)
+   {
+      m0x = x[i1]-x[i0];
+      m0y = y[i1]-y[i0];
    }
-   if(p2.position == LP_END)
+   else
    {
-      p2.tangent.x = p2.point.x - p1.point.x;
-      p2.tangent.y = p2.point.y - p1.point.y;
+      assert(i0 > 0);
+      m0x = (x[i1] - x[i0-1])*_tension;
+      m0y = (y[i1] - y[i0-1])*_tension;
    }
-   // Since the current point is not a start, it must be either the
-   // end or a continue point.  We use the same rule for generating
-   // the tangent in both cases.
-   p1.tangent = ccpMult(ccpSub(p2.point, p0.point), _tension);
-
+   float32 m1x = (x[i2] - x[i0])*_tension;
+   float32 m1y = (y[i2] - y[i0])*_tension;
    
-   // Now that we have tangents, estimate the spline between
-   // the last point and the current point.
    // We want to have a relatively constant number of time ticks
    // based on the distance between the points.
    const float pixelsPerTick = 2.0;
-   float distPixels = ccpDistance(p1.point, p0.point);
-   int ticks = MAX(16, distPixels/pixelsPerTick);
+   float distPixels = ccpDistance(orgPoints.Point(i1), orgPoints.Point(i0));
+   segment.x = SplineKernels::HermiteCubic(x[i0],x[i1],m0x,m1x);
+   segment.y = SplineKernels::HermiteCubic(y[i0],y[i1],m0y,m1y);
+   segment.width = SplineKernels::LinearCubic(width[i0],width[i1]);
+   segment.uniformTicks = MAX(16, distPixels/pixelsPerTick);
+   return true;
+}
+
+void LineSmootherCardinal::CalculateSmoothPoints(uint32 newPointIndex)
+{
+   ORIGINAL_POINT_ARRAYS& orgPoints = GetOriginalPoints();
+   SMOOTHED_POINT_ARRAYS& smoothPoints = GetSmoothedPoints();
    
-   double dt = 1.0/(ticks);
-   SMOOTHED_POINT smPt;
-   for(int idx = 0; idx < ticks; idx++)
+   SEGMENT_T segment;
+   if(!GetSegment(newPointIndex, segment))
    {
-      float time = idx*dt;
-      if(p0.position == LP_BEGIN && idx == 0)
-      {
-         smPt.position = LP_BEGIN;
-         smPt.point = p0.point;
-      }
-      else if(p1.position == LP_END && idx == (ticks))
-      {
-         smPt.position = LP_END;
-         smPt.point = p1.point;
-      }
-      else
-      {
-         smPt.position = LP_CONTINUE;
-         smPt.point = HermiteSpline(time, p0.point, p1.point, p0.tangent, p1.tangent);
-      }
-      smPt.widthPixels = MathUtilities::LinearTween(time, p0.widthPixels, p1.widthPixels);
-      smoothPoints.push_back(smPt);
-      //      CCLOG("Pushed point (%f,%f) onto smoothed points (size = %d) (position = %s)",
-      //      smPt.point.x,smPt.point.y,smoothPoints.size(),smPt.position == LP_BEGIN?"BEGIN":smPt.position==LP_END?"END":"CONTINUE");
+      return;
+   }
+   const uint32 i2 = newPointIndex;
+   const uint32 i1 = newPointIndex-1;
+   const uint32 i0 = newPointIndex-2;
+   
+   // Keep the tangents with the points for anyone looking at them.
+   vector<float32>& tangentX = orgPoints.tangentX;
+   vector<float32>& tangentY = orgPoints.tangentY;
+   if(orgPoints.position[i0] == LP_BEGIN)
+   {
+      tangentX[i0] = orgPoints.x[i1]-orgPoints.x[i0];
+      tangentY[i0] = orgPoints.y[i1]-orgPoints.y[i0];
+   }
+   if(orgPoints.position[i2] == LP_END)
+   {
+      tangentX[i2] = orgPoints.x[i2] - orgPoints.x[i1];
+      tangentY[i2] = orgPoints.y[i2] - orgPoints.y[i1];
+   }
+   tangentX[i1] = (orgPoints.x[i2] - orgPoints.x[i0])*_tension;
+   tangentY[i1] = (orgPoints.y[i2] - orgPoints.y[i0])*_tension;
+   
+   uint32 first = AddSmoothedSegment(segment);
+   if(orgPoints.position[i0] == LP_BEGIN)
+   {  // t = 0 lands exactly on the start point.
+      smoothPoints.position[first] = LP_BEGIN;
    }
    // Mark the index for the smoothed data.
-   if(p2.position == LP_END)
+   if(orgPoints.position[i2] == LP_END)
    {
       // The last point is the END point.
-      smoothPoints[smoothPoints.size()-1].position = LP_END;
+      EndSmoothedLine(segment);
    }
-}
\ No newline at end of file
+}
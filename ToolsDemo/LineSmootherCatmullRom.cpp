@@ -25,84 +25,76 @@
  */
 
 #include "LineSmootherCatmullRom.h"
-#include "MathUtilities.h"
+#include "SplineKernels.h"
 
-void LineSmootherCatmullRom::CalculateSmoothPoints(uint32 newPointIndex)
+bool LineSmootherCatmullRom::GetSegment(uint32 newPointIndex, SEGMENT_T& segment) const
 {
    const float pixelsPerTick = 2.0;
    
-   vector<ORIGINAL_POINT>& orgPoints = GetOriginalPoints();
-   vector<SMOOTHED_POINT>& smoothPoints = GetSmoothedPoints();
+   const ORIGINAL_POINT_ARRAYS& orgPoints = GetOriginalPointsConst();
+   const vector<float32>& x = orgPoints.x;
+   const vector<float32>& y = orgPoints.y;
+   const vector<float32>& width = orgPoints.widthPixels;
    
-   if(orgPoints.size() < 3)
+   if(newPointIndex < 2 || GetStrokeIndex(newPointIndex) < 2)
    {
-      return;
+      return false;
    }
    
-   if(newPointIndex == 2)
+   if(GetStrokeIndex(newPointIndex) == 2)
    {  // Must mean we have only 3 points in there.
       // So the first point is the starting point.
-      ORIGINAL_POINT& p0 = orgPoints[newPointIndex-2];
-      ORIGINAL_POINT& p1 = orgPoints[newPointIndex-1];
-      ORIGINAL_POINT& p2 = orgPoints[newPointIndex];
+      const uint32 i0 = newPointIndex-2;
+      const uint32 i1 = newPointIndex-1;
       
       // Fill in the curve between the first point and the second.
-      float distPixels = ccpDistance(p0.point, p1.point);
-      int ticks = MAX(4, distPixels/pixelsPerTick);
-      double dt = 1.0/(ticks);
-      SMOOTHED_POINT smPt;
-      smPt.position = LP_CONTINUE;
-      for(int idx = 0; idx < ticks; idx++)
-      {
-         float time = idx*dt;
-         smPt.point.x = MathUtilities::LinearTween(time,p0.point.x,p1.point.x);
-         smPt.point.y = MathUtilities::LinearTween(time,p0.point.y,p1.point.y);
-         smPt.widthPixels = MathUtilities::LinearTween(time, p0.widthPixels, p1.widthPixels);
-         smoothPoints.push_back(smPt);
-      }
-      // The first point is ALWAYS a beginning point.
-      smoothPoints[0].position = LP_BEGIN;
-      // If this is a REALLY short line, mark the end.
-      if(p2.position == LP_END || p1.position == LP_END)
-      {
-         smoothPoints[smoothPoints.size()-1].position = LP_END;
-      }
+      float distPixels = ccpDistance(orgPoints.Point(i0), orgPoints.Point(i1));
+      segment.x = SplineKernels::LinearCubic(x[i0],x[i1]);
+      segment.y = SplineKernels::LinearCubic(y[i0],y[i1]);
+      segment.width = SplineKernels::LinearCubic(width[i0],width[i1]);
+      segment.uniformTicks = MAX(4, distPixels/pixelsPerTick);
    }
    else
    {  // Beyond three points.
       // We can process the data
-      ORIGINAL_POINT& p3 = orgPoints[newPointIndex];
-      ORIGINAL_POINT& p2 = orgPoints[newPointIndex-1];
-      ORIGINAL_POINT& p1 = orgPoints[newPointIndex-2];
-      ORIGINAL_POINT& p0 = orgPoints[newPointIndex-3];
+      const uint32 i3 = newPointIndex;
+      const uint32 i2 = newPointIndex-1;
+      const uint32 i1 = newPointIndex-2;
+      const uint32 i0 = newPointIndex-3;
       
-      float distPixels = ccpDistance(p2.point, p1.point);
-      int ticks = MAX(4, distPixels/pixelsPerTick);
-      double dt = 1.0/(ticks);
-      SMOOTHED_POINT smPt;
-      smPt.position = LP_CONTINUE;
-      for(int idx = 0; idx < ticks; idx++)
-      {
-         float time = idx*dt;
-         float tSq = time*time;
-         float tCube = tSq*time;
-         CCPoint pt;
-         
-         CCPoint b0 = ccpMult(p0.point,2*tSq -tCube - time);
-         CCPoint b1 = ccpMult(p1.point,3*tCube-5*tSq + 2);
-         CCPoint b2 = ccpMult(p2.point,4*tSq - 3*tCube + time);
-         CCPoint b3 = ccpMult(p3.point,tCube-tSq);
-         
-         pt.x = 0.5*(b0.x+b1.x+b2.x+b3.x);
-         pt.y = 0.5*(b0.y+b1.y+b2.y+b3.y);
-         smPt.point = pt;
-         smPt.widthPixels = MathUtilities::LinearTween(time, p1.widthPixels, p2.widthPixels);
-         smoothPoints.push_back(smPt);
-       }
-      if(p3.position == LP_END)
+      float distPixels = ccpDistance(orgPoints.Point(i2), orgPoints.Point(i1));
+      segment.x = SplineKernels::CatmullRomCubic(x[i0],x[i1],x[i2],x[i3]);
+      segment.y = SplineKernels::CatmullRomCubic(y[i0],y[i1],y[i2],y[i3]);
+      segment.width = SplineKernels::LinearCubic(width[i1],width[i2]);
+      segment.uniformTicks = MAX(4, distPixels/pixelsPerTick);
+   }
+   return true;
+}
+
+void LineSmootherCatmullRom::CalculateSmoothPoints(uint32 newPointIndex)
+{
+   ORIGINAL_POINT_ARRAYS& orgPoints = GetOriginalPoints();
+   SMOOTHED_POINT_ARRAYS& smoothPoints = GetSmoothedPoints();
+   
+   SEGMENT_T segment;
+   if(!GetSegment(newPointIndex, segment))
+   {
+      return;
+   }
+   AddSmoothedSegment(segment);
+   if(GetStrokeIndex(newPointIndex) == 2)
+   {
+      // The first point is ALWAYS a beginning point.
+      smoothPoints.position[0] = LP_BEGIN;
+      // If this is a REALLY short line, mark the end.
+      if(orgPoints.position[newPointIndex] == LP_END || orgPoints.position[newPointIndex-1] == LP_END)
       {
-         // The last point is the END point.
-         smoothPoints[smoothPoints.size()-1].position = LP_END;
+         EndSmoothedLine(segment);
       }
    }
-}
\ No newline at end of file
+   else if(orgPoints.position[newPointIndex] == LP_END)
+   {
+      // The last point is the END point.
+      EndSmoothedLine(segment);
+   }
+}
@@ -35,6 +35,7 @@ protected:
    // Given a new original point at newPointIndex, calculate a new
    // set of smoothed points and add them to the smoothPoints list.
    virtual void CalculateSmoothPoints(uint32 newPointIndex);
+   virtual bool GetSegment(uint32 newPointIndex, SEGMENT_T& segment) const;
 };
 
 #endif /* defined(__ToolsDemo__LineSmootherCatmullRom__) */
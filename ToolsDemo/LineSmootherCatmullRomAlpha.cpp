@@ -0,0 +1,167 @@
+/********************************************************************
+ * File   : LineSmootherCatmullRomAlpha.cpp
+ * Project: ToolsDemo
+ *
+ ********************************************************************
+ * Created on 10/19/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+#include "LineSmootherCatmullRomAlpha.h"
+
+// Keeps repeated points from making a zero length knot interval.
+const float MIN_KNOT_INTERVAL = 1.0e-4f;
+
+LineSmootherCatmullRomAlpha::LineSmootherCatmullRomAlpha(float alpha) :
+   _knotCount(0)
+{
+   SetAlpha(alpha);
+}
+
+void LineSmootherCatmullRomAlpha::SetAlpha(float alpha)
+{
+   if(alpha < 0.0f || alpha > 1.0f)
+   {
+      throw std::out_of_range("alpha must be in [0,1]");
+   }
+   _alpha = alpha;
+}
+
+float LineSmootherCatmullRomAlpha::GetKnotInterval(uint32 pointIndex) const
+{
+   assert(pointIndex > 0);
+   const ORIGINAL_POINT_ARRAYS& orgPoints = GetOriginalPointsConst();
+   float dx = orgPoints.x[pointIndex] - orgPoints.x[pointIndex-1];
+   float dy = orgPoints.y[pointIndex] - orgPoints.y[pointIndex-1];
+   // |d|^alpha == (|d|^2)^(alpha/2), which saves a sqrt.
+   return MAX(powf(dx*dx + dy*dy, 0.5f*_alpha), MIN_KNOT_INTERVAL);
+}
+
+void LineSmootherCatmullRomAlpha::AddKnotInterval(uint32 newPointIndex)
+{
+   if(GetStrokeIndex(newPointIndex) == 0)
+   {  // A new stroke.
+      _knotCount = 0;
+      return;
+   }
+   _knotIntervals[0] = _knotIntervals[1];
+   _knotIntervals[1] = _knotIntervals[2];
+   _knotIntervals[2] = GetKnotInterval(newPointIndex);
+   _knotCount = MIN(_knotCount+1, 3);
+}
+
+void LineSmootherCatmullRomAlpha::BuildSegment(uint32 newPointIndex,
+                                               float d01, float d12, float d23,
+                                               SEGMENT_T& segment) const
+{
+   const float pixelsPerTick = 2.0;
+   
+   const ORIGINAL_POINT_ARRAYS& orgPoints = GetOriginalPointsConst();
+   const vector<float32>& x = orgPoints.x;
+   const vector<float32>& y = orgPoints.y;
+   const vector<float32>& width = orgPoints.widthPixels;
+   
+   if(GetStrokeIndex(newPointIndex) == 2)
+   {  // Must mean we have only 3 points in there.
+      // There is no point before the first one, so the first
+      // segment is a straight line (the same as LineSmootherCatmullRom).
+      const uint32 i0 = newPointIndex-2;
+      const uint32 i1 = newPointIndex-1;
+      
+      float distPixels = ccpDistance(orgPoints.Point(i0), orgPoints.Point(i1));
+      segment.x = SplineKernels::LinearCubic(x[i0],x[i1]);
+      segment.y = SplineKernels::LinearCubic(y[i0],y[i1]);
+      segment.width = SplineKernels::LinearCubic(width[i0],width[i1]);
+      segment.uniformTicks = MAX(4, distPixels/pixelsPerTick);
+   }
+   else
+   {  // Beyond three points.
+      const uint32 i3 = newPointIndex;
+      const uint32 i2 = newPointIndex-1;
+      const uint32 i1 = newPointIndex-2;
+      const uint32 i0 = newPointIndex-3;
+      
+      float distPixels = ccpDistance(orgPoints.Point(i2), orgPoints.Point(i1));
+      segment.x = SplineKernels::CatmullRomCubic(x[i0],x[i1],x[i2],x[i3],d01,d12,d23);
+      segment.y = SplineKernels::CatmullRomCubic(y[i0],y[i1],y[i2],y[i3],d01,d12,d23);
+      segment.width = SplineKernels::LinearCubic(width[i1],width[i2]);
+      segment.uniformTicks = MAX(4, distPixels/pixelsPerTick);
+   }
+}
+
+bool LineSmootherCatmullRomAlpha::GetSegment(uint32 newPointIndex, SEGMENT_T& segment) const
+{
+   if(newPointIndex < 2 || GetStrokeIndex(newPointIndex) < 2)
+   {
+      return false;
+   }
+   if(GetStrokeIndex(newPointIndex) == 2)
+   {  // No knot intervals needed for the first (straight) segment.
+      BuildSegment(newPointIndex, 0.0f, 0.0f, 0.0f, segment);
+   }
+   else
+   {  // Work the intervals out from the points (SmoothAll(...) does not
+      // go through CalculateSmoothPoints(...) to keep the cached ones).
+      BuildSegment(newPointIndex,
+                   GetKnotInterval(newPointIndex-2),
+                   GetKnotInterval(newPointIndex-1),
+                   GetKnotInterval(newPointIndex),
+                   segment);
+   }
+   return true;
+}
+
+void LineSmootherCatmullRomAlpha::CalculateSmoothPoints(uint32 newPointIndex)
+{
+   AddKnotInterval(newPointIndex);
+   
+   ORIGINAL_POINT_ARRAYS& orgPoints = GetOriginalPoints();
+   SMOOTHED_POINT_ARRAYS& smoothPoints = GetSmoothedPoints();
+   
+   if(orgPoints.size() < 3 || GetStrokeIndex(newPointIndex) < 2)
+   {
+      return;
+   }
+   
+   SEGMENT_T segment;
+   if(GetStrokeIndex(newPointIndex) == 2)
+   {
+      BuildSegment(newPointIndex, 0.0f, 0.0f, 0.0f, segment);
+      AddSmoothedSegment(segment);
+      // The first point is ALWAYS a beginning point.
+      smoothPoints.position[0] = LP_BEGIN;
+      // If this is a REALLY short line, mark the end.
+      if(orgPoints.position[newPointIndex] == LP_END || orgPoints.position[newPointIndex-1] == LP_END)
+      {
+         EndSmoothedLine(segment);
+      }
+   }
+   else
+   {
+      assert(_knotCount == 3);
+      BuildSegment(newPointIndex, _knotIntervals[0], _knotIntervals[1], _knotIntervals[2], segment);
+      AddSmoothedSegment(segment);
+      if(orgPoints.position[newPointIndex] == LP_END)
+      {
+         // The last point is the END point.
+         EndSmoothedLine(segment);
+      }
+   }
+}
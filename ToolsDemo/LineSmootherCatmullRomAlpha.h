@@ -0,0 +1,85 @@
+/********************************************************************
+ * File   : LineSmootherCatmullRomAlpha.h
+ * Project: ToolsDemo
+ *
+ ********************************************************************
+ * Created on 10/19/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+#ifndef __ToolsDemo__LineSmootherCatmullRomAlpha__
+#define __ToolsDemo__LineSmootherCatmullRomAlpha__
+
+#include "LineSmoother.h"
+
+/* Catmull-Rom with the knots spaced by |Pi+1 - Pi|^alpha instead of 1:
+ *
+ *    alpha = 0.0  uniform (same curve as LineSmootherCatmullRom)
+ *    alpha = 0.5  centripetal - no cusps or self intersections inside a
+ *                 segment, and it hugs the input points on uneven input.
+ *    alpha = 1.0  chordal - follows the chords even more closely.
+ *
+ * Each knot interval is worked out once, when its point arrives, and
+ * the last three are kept.  A segment turns into one cubic per axis
+ * (see SplineKernels::CatmullRomCubic), so the per tick cost is the
+ * same as the uniform smoother.
+ */
+class LineSmootherCatmullRomAlpha : public LineSmoother
+{
+private:
+   float _alpha;
+   // The knot intervals between the last four original points, oldest
+   // first, and how many of them are valid for the current stroke.
+   float _knotIntervals[3];
+   uint32 _knotCount;
+   
+   // The knot interval between the points at pointIndex-1 and pointIndex.
+   float GetKnotInterval(uint32 pointIndex) const;
+   void AddKnotInterval(uint32 newPointIndex);
+   void BuildSegment(uint32 newPointIndex, float d01, float d12, float d23,
+                     SEGMENT_T& segment) const;
+   
+protected:
+   // Given a new original point at newPointIndex, calculate a new
+   // set of smoothed points and add them to the smoothPoints list.
+   virtual void CalculateSmoothPoints(uint32 newPointIndex);
+   virtual bool GetSegment(uint32 newPointIndex, SEGMENT_T& segment) const;
+   
+public:
+   // Change it between strokes, not during one.
+   void SetAlpha(float alpha);
+   float GetAlpha() const { return _alpha; }
+   
+   LineSmootherCatmullRomAlpha(float alpha = 0.5f);
+};
+
+class LineSmootherCentripetal : public LineSmootherCatmullRomAlpha
+{
+public:
+   LineSmootherCentripetal() : LineSmootherCatmullRomAlpha(0.5f) {}
+};
+
+class LineSmootherChordal : public LineSmootherCatmullRomAlpha
+{
+public:
+   LineSmootherChordal() : LineSmootherCatmullRomAlpha(1.0f) {}
+};
+
+#endif /* defined(__ToolsDemo__LineSmootherCatmullRomAlpha__) */
@@ -0,0 +1,189 @@
+/********************************************************************
+ * File   : LineSmootherPool.cpp
+ * Project: ToolsDemo
+ *
+ ********************************************************************
+ * Created on 10/19/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+#include "LineSmootherPool.h"
+
+LineSmootherPool::LineSmootherPool(CREATE_SMOOTHER_T createSmoother, uint32 workerThreads) :
+   _createSmoother(createSmoother)
+{
+   if(createSmoother == NULL)
+   {
+      throw std::out_of_range("createSmoother == NULL");
+   }
+   _workers.Init(workerThreads);
+}
+
+LineSmootherPool::~LineSmootherPool()
+{
+   _workers.Shutdown();
+   Reset();
+   for(uint32 idx = 0; idx < _free.size(); idx++)
+   {
+      delete _free[idx];
+   }
+   _free.clear();
+}
+
+void LineSmootherPool::Reserve(uint32 count)
+{
+   uint32 existing = _active.size() + _completed.size() + _free.size();
+   for(uint32 idx = existing; idx < count; idx++)
+   {
+      _free.push_back(_createSmoother());
+   }
+}
+
+int32 LineSmootherPool::FindActive(int32 touchID) const
+{
+   for(uint32 idx = 0; idx < _active.size(); idx++)
+   {
+      if(_active[idx].touchID == touchID)
+      {
+         return idx;
+      }
+   }
+   return -1;
+}
+
+LineSmoother* LineSmootherPool::GetActive(int32 touchID) const
+{
+   int32 index = FindActive(touchID);
+   return index < 0 ? NULL : _active[index].smoother;
+}
+
+LineSmoother* LineSmootherPool::GetActiveOrThrow(int32 touchID) const
+{
+   LineSmoother* smoother = GetActive(touchID);
+   if(smoother == NULL)
+   {
+      throw std::out_of_range("touchID has no active stroke");
+   }
+   return smoother;
+}
+
+LineSmoother* LineSmootherPool::AcquireSmoother()
+{
+   if(_free.empty())
+   {
+      return _createSmoother();
+   }
+   LineSmoother* smoother = _free.back();
+   _free.pop_back();
+   return smoother;
+}
+
+void LineSmootherPool::ReleaseSmoother(LineSmoother* smoother)
+{
+   // Reset() clears the points but keeps the memory.
+   smoother->Reset();
+   _free.push_back(smoother);
+}
+
+LineSmoother* LineSmootherPool::LineBegin(int32 touchID, const CCPoint& point, double timestamp)
+{
+   int32 index = FindActive(touchID);
+   if(index >= 0)
+   {  // We never saw the end of the last stroke for this touch.
+      _completed.push_back(_active[index]);
+      _active.erase(_active.begin()+index);
+   }
+   STROKE_T stroke;
+   stroke.touchID = touchID;
+   stroke.smoother = AcquireSmoother();
+   stroke.smoother->LineBegin(point, timestamp);
+   _active.push_back(stroke);
+   return stroke.smoother;
+}
+
+LineSmoother* LineSmootherPool::LineContinue(int32 touchID, const CCPoint& point, double timestamp)
+{
+   LineSmoother* smoother = GetActiveOrThrow(touchID);
+   smoother->LineContinue(point, timestamp);
+   return smoother;
+}
+
+LineSmoother* LineSmootherPool::LineEnd(int32 touchID, const CCPoint& point, double timestamp)
+{
+   int32 index = FindActive(touchID);
+   if(index < 0)
+   {
+      throw std::out_of_range("touchID has no active stroke");
+   }
+   STROKE_T stroke = _active[index];
+   _active.erase(_active.begin()+index);
+   stroke.smoother->LineEnd(point, timestamp);
+   _completed.push_back(stroke);
+   return stroke.smoother;
+}
+
+void LineSmootherPool::Cancel(int32 touchID)
+{
+   int32 index = FindActive(touchID);
+   if(index >= 0)
+   {
+      ReleaseSmoother(_active[index].smoother);
+      _active.erase(_active.begin()+index);
+   }
+}
+
+void LineSmootherPool::ProcessItem(void* job, uint32 index)
+{
+   PROCESS_JOB_T* processJob = (PROCESS_JOB_T*)job;
+   const STROKE_T& stroke = (*processJob->strokes)[index];
+   processJob->func(processJob->context, stroke.touchID, stroke.smoother);
+}
+
+void LineSmootherPool::ProcessCompleted(PROCESS_STROKE_T func, void* context)
+{
+   if(func == NULL)
+   {
+      throw std::out_of_range("func == NULL");
+   }
+   PROCESS_JOB_T job;
+   job.strokes = &_completed;
+   job.func = func;
+   job.context = context;
+   _workers.ParallelFor(_completed.size(), ProcessItem, &job);
+}
+
+void LineSmootherPool::ReleaseCompleted()
+{
+   for(uint32 idx = 0; idx < _completed.size(); idx++)
+   {
+      ReleaseSmoother(_completed[idx].smoother);
+   }
+   _completed.clear();
+}
+
+void LineSmootherPool::Reset()
+{
+   for(uint32 idx = 0; idx < _active.size(); idx++)
+   {
+      ReleaseSmoother(_active[idx].smoother);
+   }
+   _active.clear();
+   ReleaseCompleted();
+}
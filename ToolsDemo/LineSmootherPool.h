@@ -0,0 +1,134 @@
+/********************************************************************
+ * File   : LineSmootherPool.h
+ * Project: ToolsDemo
+ *
+ ********************************************************************
+ * Created on 10/19/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+#ifndef __ToolsDemo__LineSmootherPool__
+#define __ToolsDemo__LineSmootherPool__
+
+#include "CommonSTL.h"
+#include "CommonProject.h"
+#include "LineSmoother.h"
+#include "WorkerPool.h"
+
+/* Runs any number of strokes at the same time, one LineSmoother per
+ * touch ID (e.g. several fingers, or replaying recorded strokes).
+ *
+ * A stroke goes through three stages:
+ *
+ *    active    - LineBegin(...) for a touch ID until LineEnd(...) for it.
+ *    completed - after LineEnd(...).  The smoother still holds the
+ *                stroke's points so they can be drawn, or handed to
+ *                ProcessCompleted(...) to be worked on in parallel.
+ *    free      - after ReleaseCompleted(), Cancel(...) or Reset().  The
+ *                smoother is Reset() and kept for the next LineBegin(...),
+ *                so its buffers are reused instead of reallocated.
+ *
+ * New smoothers are only made (with the create function passed to the
+ * constructor) when there is no free one.  Use Reserve(...) to make
+ * them up front.
+ *
+ * The pool owns its smoothers.  Pointers it hands out stay valid
+ * until the stroke is released.
+ *
+ * There are only ever a handful of active strokes, so they are kept in
+ * a small vector and found by a linear search on the touch ID.
+ */
+class LineSmootherPool
+{
+public:
+   typedef LineSmoother* (*CREATE_SMOOTHER_T)();
+   typedef void (*PROCESS_STROKE_T)(void* context, int32 touchID, LineSmoother* smoother);
+   
+   typedef struct
+   {
+      int32 touchID;
+      LineSmoother* smoother;
+   } STROKE_T;
+   
+private:
+   CREATE_SMOOTHER_T _createSmoother;
+   vector<STROKE_T> _active;
+   vector<STROKE_T> _completed;
+   vector<LineSmoother*> _free;
+   WorkerPool _workers;
+   
+   // Used to pass ProcessCompleted(...)'s arguments to the workers.
+   typedef struct
+   {
+      const vector<STROKE_T>* strokes;
+      PROCESS_STROKE_T func;
+      void* context;
+   } PROCESS_JOB_T;
+   static void ProcessItem(void* job, uint32 index);
+   
+   int32 FindActive(int32 touchID) const;
+   LineSmoother* GetActiveOrThrow(int32 touchID) const;
+   LineSmoother* AcquireSmoother();
+   void ReleaseSmoother(LineSmoother* smoother);
+   
+   // Not copyable.
+   LineSmootherPool(const LineSmootherPool&);
+   LineSmootherPool& operator=(const LineSmootherPool&);
+   
+public:
+   // workerThreads threads (plus the caller) are used by
+   // ProcessCompleted(...).  0 means do everything on the caller.
+   LineSmootherPool(CREATE_SMOOTHER_T createSmoother, uint32 workerThreads = 0);
+   ~LineSmootherPool();
+   
+   // Make sure at least count smoothers exist (active + completed + free).
+   void Reserve(uint32 count);
+   
+   // The same as the LineSmoother calls, for the stroke of touchID.
+   // They return the stroke's smoother.  LineContinue(...) and
+   // LineEnd(...) throw if touchID has no active stroke.  If touchID is
+   // already active when LineBegin(...) is called (its end was missed),
+   // the old stroke is completed first.
+   LineSmoother* LineBegin(int32 touchID, const CCPoint& point, double timestamp);
+   LineSmoother* LineContinue(int32 touchID, const CCPoint& point, double timestamp);
+   LineSmoother* LineEnd(int32 touchID, const CCPoint& point, double timestamp);
+   
+   // Drop an active stroke (e.g. the touch was cancelled).
+   void Cancel(int32 touchID);
+   
+   // The smoother for an active stroke, or NULL.
+   LineSmoother* GetActive(int32 touchID) const;
+   const vector<STROKE_T>& GetActiveStrokes() const { return _active; }
+   const vector<STROKE_T>& GetCompletedStrokes() const { return _completed; }
+   
+   // Call func(context, touchID, smoother) for every completed stroke,
+   // spread over the worker threads.  Returns when all are done.
+   // func is called from several threads at once, so it may only touch
+   // its own stroke (and thread safe data in context).
+   void ProcessCompleted(PROCESS_STROKE_T func, void* context);
+   
+   // Move all the completed strokes to the free list.
+   void ReleaseCompleted();
+   
+   // Release every stroke, active or completed.
+   void Reset();
+};
+
+#endif /* defined(__ToolsDemo__LineSmootherPool__) */
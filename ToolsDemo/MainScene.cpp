@@ -27,20 +27,48 @@
 #include "MainScene.h"
 #include "LineSmootherCatmullRom.h"
 #include "LineSmootherCardinal.h"
+#include "LineSmootherCatmullRomAlpha.h"
+#include "LineSmootherPool.h"
+#include "LineSimplifier.h"
 #include "DebugLinesLayer.h"
 #include "DebugMenuLayer.h"
 #include "SmoothLinesLayer.h"
 #include "TapDragPinchInput.h"
 
-MainScene::MainScene()
+// How far the canvas can be zoomed out and in.
+const float MIN_CANVAS_ZOOM = 0.25f;
+const float MAX_CANVAS_ZOOM = 4.0f;
+
+static LineSmoother* CreateLineSmoother()
+{
+   // Centripetal Catmull-Rom does not overshoot or form cusps on uneven
+   // input the way the uniform one does.
+   LineSmoother* lineSmoother = new LineSmootherCentripetal();
+   //   LineSmoother* lineSmoother = new LineSmootherCatmullRom();
+   //   LineSmoother* lineSmoother = new LineSmootherChordal();
+   //   LineSmoother* lineSmoother = new LineSmootherCardinal();
+   lineSmoother->SetTessellationMode(LineSmoother::TM_ADAPTIVE);
+   // Widths that keep up with the stroke speeding up and slowing down.
+   lineSmoother->SetVelocityFilter(LineSmoother::VF_ONE_EURO);
+   lineSmoother->SetStreaming(true);
+   // Drop samples that are within a pixel of the last one kept (the
+   // finger resting or crawling).
+   lineSmoother->SetPointFilter(new RadialDistanceFilter(1.0f));
+   return lineSmoother;
+}
+
+MainScene::MainScene() :
+   _smoothLinesLayer(NULL),
+   _debugLinesLayer(NULL),
+   _pinchStartPan(CCPointZero),
+   _pinchStartZoom(1.0f)
 {
-   _lineSmoother = new LineSmootherCatmullRom();
-   //   _lineSmoother = new LineSmootherCardinal();
+   _lineSmoothers = new LineSmootherPool(CreateLineSmoother);
 }
 
 MainScene::~MainScene()
 {
-   delete _lineSmoother;
+   delete _lineSmoothers;
 }
 
 bool MainScene::init()
@@ -62,10 +90,11 @@ bool MainScene::init()
    
    // Adding the debug lines so that we can draw the original
    // and smoothed data.
-   layer = DebugLinesLayer::create();
-   layer->setVisible(false);
-   assert(layer != NULL);
-   addChild(layer);
+   _debugLinesLayer = DebugLinesLayer::create();
+   assert(_debugLinesLayer != NULL);
+   _debugLinesLayer->setVisible(false);
+   addChild(_debugLinesLayer);
+   SetCanvasView(CCPointZero, 1.0f);
    
    // Add the menu.
    CreateMenu();
@@ -75,6 +104,12 @@ bool MainScene::init()
    assert(node != NULL);
    addChild(node);
    
+   // Events posted by other threads are delivered in update(...).  These
+   // only need to happen once a frame, however many times they are posted.
+   Notifier::Instance().SetDeliveryPolicy(Notifier::NE_RESET_DRAW_CYCLE, Notifier::DP_COALESCE);
+   Notifier::Instance().SetDeliveryPolicy(Notifier::NE_DEBUG_LINES_TOGGLE_VISIBILITY, Notifier::DP_COALESCE);
+   scheduleUpdate();
+   
    return true;
 }
 
@@ -109,7 +144,7 @@ void MainScene::onEnterTransitionDidFinish()
    // It is a good practice to attach/detach from the Notifier
    // on screen transition times.  This gets you out of the question
    // of when the scene deletion occurs.
-   Notifier::Instance().Attach(this, Notifier::NE_DEBUG_BUTTON_PRESSED);
+   Notifier::Channel<Notifier::NE_DEBUG_BUTTON_PRESSED>().Attach<MainScene,&MainScene::DebugButtonPressed>(this);
 }
 
 void MainScene::onExitTransitionDidStart()
@@ -121,18 +156,16 @@ void MainScene::onExitTransitionDidStart()
    Notifier::Instance().Detach(this);
 }
 
-// Handler for Notifier Events
-void MainScene::Notify(Notifier::NOTIFIED_EVENT_TYPE_T eventType, const void* eventData)
+void MainScene::update(float dt)
 {
-   switch(eventType)
-   {
-      default:
-         assert(false);
-         break;
-      case Notifier::NE_DEBUG_BUTTON_PRESSED:
-         HandleMenuChoice((uint32)eventData);
-         break;
-   }
+   CCScene::update(dt);
+   Notifier::Instance().DispatchPending();
+}
+
+// Handlers for Notifier Events
+void MainScene::DebugButtonPressed(const uint32& buttonTag)
+{
+   HandleMenuChoice(buttonTag);
 }
 
 // Handler for Tap/Drag/Pinch Events
@@ -146,31 +179,31 @@ void MainScene::TapDragPinchInputLongTap(const TOUCH_DATA_T& point)
 }
 void MainScene::TapDragPinchInputPinchBegin(const TOUCH_DATA_T& point0, const TOUCH_DATA_T& point1)
 {
-   
+   _pinchStartPan = _smoothLinesLayer->getPosition();
+   _pinchStartZoom = _smoothLinesLayer->getScale();
 }
 void MainScene::TapDragPinchInputPinchContinue(const TOUCH_DATA_T& point0, const TOUCH_DATA_T& point1)
 {
-   
+   UpdatePinch(point0, point1);
 }
 void MainScene::TapDragPinchInputPinchEnd(const TOUCH_DATA_T& point0, const TOUCH_DATA_T& point1)
 {
-   
+   UpdatePinch(point0, point1);
 }
 void MainScene::TapDragPinchInputDragBegin(const TOUCH_DATA_T& point0, const TOUCH_DATA_T& point1)
 {
-   _lineSmoother->LineBegin(point0.pos,point0.timestamp);
-   _lineSmoother->LineContinue(point1.pos,point1.timestamp);
-   DrawLines();
+   _lineSmoothers->LineBegin(point1.ID,ToCanvas(point0.pos),point0.timestamp);
+   DrawLines(_lineSmoothers->LineContinue(point1.ID,ToCanvas(point1.pos),point1.timestamp));
 }
 void MainScene::TapDragPinchInputDragContinue(const TOUCH_DATA_T& point0, const TOUCH_DATA_T& point1)
 {
-   _lineSmoother->LineContinue(point1.pos,point1.timestamp);
-   DrawLines();
+   DrawLines(_lineSmoothers->LineContinue(point1.ID,ToCanvas(point1.pos),point1.timestamp));
 }
 void MainScene::TapDragPinchInputDragEnd(const TOUCH_DATA_T& point0, const TOUCH_DATA_T& point1)
 {
-   _lineSmoother->LineEnd(point1.pos,point1.timestamp);
-   DrawLines();
+   DrawLines(_lineSmoothers->LineEnd(point1.ID,ToCanvas(point1.pos),point1.timestamp));
+   // Everything has been handed to the layer, so the smoother can be reused.
+   _lineSmoothers->ReleaseCompleted();
 }
 
 void MainScene::CreateMenu()
@@ -191,14 +224,46 @@ void MainScene::CreateMenu()
 
 void MainScene::ResetDisplay()
 {
-   _lineSmoother->Reset();
+   _lineSmoothers->Reset();
    _smoothLinesLayer->Reset();
-   Notifier::Instance().Notify(Notifier::NE_RESET_DRAW_CYCLE);
+   Notifier::Channel<Notifier::NE_RESET_DRAW_CYCLE>().Notify();
 }
 
-void MainScene::ToggleDebug()
+void MainScene::SetCanvasView(const CCPoint& pan, float zoom)
 {
-   Notifier::Instance().Notify(Notifier::NE_DEBUG_LINES_TOGGLE_VISIBILITY);
+   // Both layers scale around their origin, so the canvas point p is
+   // on the screen at pan + zoom*p.
+   _smoothLinesLayer->setAnchorPoint(ccp(0,0));
+   _smoothLinesLayer->setPosition(pan);
+   _smoothLinesLayer->setScale(zoom);
+   _debugLinesLayer->setAnchorPoint(ccp(0,0));
+   _debugLinesLayer->setPosition(pan);
+   _debugLinesLayer->setScale(zoom);
+}
+
+void MainScene::UpdatePinch(const TOUCH_DATA_T& point0, const TOUCH_DATA_T& point1)
+{
+   const CCPoint& start0 = GetPinchPoint0().pos;
+   const CCPoint& start1 = GetPinchPoint1().pos;
+   // Spreading the fingers zooms in.
+   float zoom = _pinchStartZoom;
+   float startDistance = ccpDistance(start0, start1);
+   if(startDistance > 0)
+   {
+      zoom = clampf(_pinchStartZoom*ccpDistance(point0.pos, point1.pos)/startDistance,
+                    MIN_CANVAS_ZOOM, MAX_CANVAS_ZOOM);
+   }
+   // The canvas point that was between the fingers when the pinch
+   // started stays between them, so moving them together pans.
+   CCPoint startMid = ccpMidpoint(start0, start1);
+   CCPoint canvasMid = ccpMult(ccpSub(startMid, _pinchStartPan), 1.0f/_pinchStartZoom);
+   CCPoint mid = ccpMidpoint(point0.pos, point1.pos);
+   SetCanvasView(ccpSub(mid, ccpMult(canvasMid, zoom)), zoom);
+}
+
+void MainScene::ToggleDebug()
+{  // Delivered (once) on the next update(...).
+   Notifier::Channel<Notifier::NE_DEBUG_LINES_TOGGLE_VISIBILITY>().Post();
 }
 
 void MainScene::HandleMenuChoice(uint32 choice)
@@ -229,19 +294,25 @@ void MainScene::HandleMenuChoice(uint32 choice)
    }
 }
 
-void MainScene::DrawLines()
+void MainScene::DrawLines(LineSmoother* smoother)
 {
-   DrawDebugOriginalLines();
-   DrawDebugSmoothedLines();
-   DrawSmoothedLines();
+   // The debug lines are collected and sent as a single batch.
+   _debugLines.clear();
+   DrawDebugOriginalLines(smoother);
+   DrawDebugSmoothedLines(smoother);
+   if(_debugLines.size() > 0)
+   {
+      Notifier::Channel<Notifier::NE_DEBUG_LINE_DRAW_ADD_LINE_PIXELS>().NotifyBatch(&_debugLines[0], _debugLines.size());
+   }
+   DrawSmoothedLines(smoother);
 }
 
 
-void MainScene::DrawDebugOriginalLines()
+void MainScene::DrawDebugOriginalLines(LineSmoother* smoother)
 {
    LINE_PIXELS_DATA lp;
    ccColor4F lineColor = ccc4f(0.8, 0.1, 0.1, 0.90);
-   const vector<LineSmoother::ORIGINAL_POINT>& points = _lineSmoother->GetOriginalPointsConst();
+   const LineSmoother::ORIGINAL_POINT_ARRAYS& points = smoother->GetOriginalPointsConst();
    // Clear ALL lines out of the debug drawing.
    
    // Get the original points, draw them
@@ -261,24 +332,24 @@ void MainScene::DrawDebugOriginalLines()
          lp.markerRadius = 8.0;
          lp.start = point.point;
          lp.end = point.point;
-         Notifier::Instance().Notify(Notifier::NE_DEBUG_LINE_DRAW_ADD_LINE_PIXELS,&lp);
+         _debugLines.push_back(lp);
          lp.start = point.point;
          lp.end = nextPoint.point;
-         Notifier::Instance().Notify(Notifier::NE_DEBUG_LINE_DRAW_ADD_LINE_PIXELS,&lp);
+         _debugLines.push_back(lp);
       }
       else if(point.position == LineSmoother::LP_END)
       {  // End of the line.
          lp.start = point.point;
          lp.end = point.point;
          lp.markerRadius = 12.0;
-         Notifier::Instance().Notify(Notifier::NE_DEBUG_LINE_DRAW_ADD_LINE_PIXELS,&lp);
+         _debugLines.push_back(lp);
       }
       else
       {  // All the other points are between begin/end.
          lp.markerRadius = 2.0;
          lp.start = point.point;
          lp.end = nextPoint.point;
-         Notifier::Instance().Notify(Notifier::NE_DEBUG_LINE_DRAW_ADD_LINE_PIXELS,&lp);
+         _debugLines.push_back(lp);
       }
       // We still have to draw the "last" last point, Since we get an update every
       // time a new point is added, we have to check if the last point is an end point
@@ -290,36 +361,36 @@ void MainScene::DrawDebugOriginalLines()
          lp.start = lastPoint.point;
          lp.end = lastPoint.point;
          lp.markerRadius = 24.0;
-         Notifier::Instance().Notify(Notifier::NE_DEBUG_LINE_DRAW_ADD_LINE_PIXELS,&lp);
+         _debugLines.push_back(lp);
       }
       
    }
 }
 
-void MainScene::DrawSmoothedLines()
+void MainScene::DrawSmoothedLines(LineSmoother* smoother)
 {
-   const vector<LineSmoother::SMOOTHED_POINT>& points = _lineSmoother->GetSmoothedPointsConst();
-   if(points.size() > _lineSmoother->GetLastSmoothPointIndex())
+   const LineSmoother::SMOOTHED_POINT_ARRAYS& points = smoother->GetSmoothedPointsConst();
+   if(points.size() > smoother->GetLastSmoothPointIndex())
    {
       // Add the points to the smoothed line layer.
-      _smoothLinesLayer->AddSmoothedPoints(points,_lineSmoother->GetLastSmoothPointIndex());
+      _smoothLinesLayer->AddSmoothedPoints(points,smoother->GetLastSmoothPointIndex());
       // Mark the last smooth point set retrieved so that we can pick up here on the next
       // point set.
-      _lineSmoother->MarkLastSmoothPointIndex();
+      smoother->MarkLastSmoothPointIndex();
    }
 }
 
-void MainScene::DrawDebugSmoothedLines()
+void MainScene::DrawDebugSmoothedLines(LineSmoother* smoother)
 {
    LINE_PIXELS_DATA lp;
    ccColor4F lineColor = ccc4f(0.15, 0.8, 0.1, 0.95);
-   const vector<LineSmoother::SMOOTHED_POINT>& points = _lineSmoother->GetSmoothedPointsConst();
+   const LineSmoother::SMOOTHED_POINT_ARRAYS& points = smoother->GetSmoothedPointsConst();
    
    // Get the original points, draw them
    lp.color = lineColor;
    if(points.size() > 1)
    {
-      for(int idx = MAX(_lineSmoother->GetLastSmoothPointIndex(),1); idx < points.size(); idx++)
+      for(int idx = MAX(smoother->GetLastSmoothPointIndex(),1); idx < points.size(); idx++)
       {
          const LineSmoother::SMOOTHED_POINT& point = points[idx-1];
          const LineSmoother::SMOOTHED_POINT& nextPoint = points[idx];
@@ -335,11 +406,11 @@ void MainScene::DrawDebugSmoothedLines()
             lp.start = point.point;
             lp.end = point.point;
             lp.width = point.widthPixels;
-            Notifier::Instance().Notify(Notifier::NE_DEBUG_LINE_DRAW_ADD_LINE_PIXELS,&lp);
+            _debugLines.push_back(lp);
             lp.start = point.point;
             lp.end = nextPoint.point;
             lp.width = point.widthPixels;
-            Notifier::Instance().Notify(Notifier::NE_DEBUG_LINE_DRAW_ADD_LINE_PIXELS,&lp);
+            _debugLines.push_back(lp);
             //           CCLOG("Drawing BEGIN: (%f,%f)",point.point.x,point.point.y);
          }
          else if(point.position == LineSmoother::LP_END)
@@ -348,7 +419,7 @@ void MainScene::DrawDebugSmoothedLines()
             lp.end = point.point;
             lp.markerRadius = 0.0;
             lp.width = point.widthPixels;
-            Notifier::Instance().Notify(Notifier::NE_DEBUG_LINE_DRAW_ADD_LINE_PIXELS,&lp);
+            _debugLines.push_back(lp);
             /*
             CCLOG("Drawing END (%d of %u): (%f,%f)",
                   idx,points.size(),
@@ -361,7 +432,7 @@ void MainScene::DrawDebugSmoothedLines()
             lp.start = point.point;
             lp.end = nextPoint.point;
             lp.width = point.widthPixels;
-            Notifier::Instance().Notify(Notifier::NE_DEBUG_LINE_DRAW_ADD_LINE_PIXELS,&lp);
+            _debugLines.push_back(lp);
             /*
              CCLOG("Drawing CONTINUE (%d of %u): (%f,%f) -> (%f,%f)",
                   idx,points.size(),
@@ -381,7 +452,7 @@ void MainScene::DrawDebugSmoothedLines()
          lp.start = lastPoint.point;
          lp.end = lastPoint.point;
          lp.markerRadius = 0.0;
-         Notifier::Instance().Notify(Notifier::NE_DEBUG_LINE_DRAW_ADD_LINE_PIXELS,&lp);
+         _debugLines.push_back(lp);
          //      CCLOG("Drawing END: (%f,%f)",lastPoint.point.x,lastPoint.point.y);
       }
    }   
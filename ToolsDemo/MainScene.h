@@ -36,8 +36,9 @@
 #include "SmoothLinesLayer.h"
 
 class LineSmoother;
+class LineSmootherPool;
 
-class MainScene : public CCScene, public Notified, public TapDragPinchInputTarget
+class MainScene : public CCScene, public NotifiedTyped, public TapDragPinchInputTarget
 {
 private:
    // This class follows the "create"/"autorelease" pattern.
@@ -45,8 +46,16 @@ private:
    MainScene();
    
    
-   LineSmoother* _lineSmoother;
+   // One smoother per touch ID.
+   LineSmootherPool* _lineSmoothers;
    SmoothLinesLayer* _smoothLinesLayer;
+   CCLayer* _debugLinesLayer;
+   // The pan and zoom when the pinch started.
+   CCPoint _pinchStartPan;
+   float _pinchStartZoom;
+   // Debug lines for the current update.  Kept around so the
+   // memory gets reused.
+   vector<LINE_PIXELS_DATA_T> _debugLines;
    
 protected:
    // This is protected so that derived classes can call it
@@ -56,12 +65,17 @@ protected:
 private:
    void CreateMenu();
    void HandleMenuChoice(uint32 choice);
-   void DrawDebugSmoothedLines();
-   void DrawDebugOriginalLines();
-   void DrawSmoothedLines();
-   void DrawLines();
+   void DrawDebugSmoothedLines(LineSmoother* smoother);
+   void DrawDebugOriginalLines(LineSmoother* smoother);
+   void DrawSmoothedLines(LineSmoother* smoother);
+   void DrawLines(LineSmoother* smoother);
    void ResetDisplay();
    void ToggleDebug();
+   // Pan and zoom the lines (and the debug lines over them).
+   void SetCanvasView(const CCPoint& pan, float zoom);
+   void UpdatePinch(const TOUCH_DATA_T& point0, const TOUCH_DATA_T& point1);
+   // Where a touch is on the canvas the lines are drawn on.
+   CCPoint ToCanvas(const CCPoint& pos) { return _smoothLinesLayer->convertToNodeSpace(pos); }
 
 public:
    
@@ -74,8 +88,12 @@ public:
    virtual void onEnterTransitionDidFinish();
    virtual void onExitTransitionDidStart();
    
-   // Handler for Notifier Events
-   virtual void Notify(Notifier::NOTIFIED_EVENT_TYPE_T eventType, const void* eventData);
+   // Called once per frame.  Delivers events posted to the Notifier
+   // from other threads.
+   virtual void update(float dt);
+   
+   // Handlers for Notifier Events
+   void DebugButtonPressed(const uint32& buttonTag);
    
    // Handler for Tap/Drag/Pinch Events
    typedef TapDragPinchInputTarget::TOUCH_DATA_T TOUCH_DATA_T;
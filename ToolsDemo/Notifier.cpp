@@ -26,17 +26,123 @@
 
 #include "Notifier.h"
 
+#ifdef NOTIFIER_STATS
+#ifdef __APPLE__
+#include <mach/mach_time.h>
+#else
+#include <time.h>
+#endif
+#include <iomanip>
+
+// A monotonic clock for timing observer calls.
+static inline uint64 StatsNanoseconds()
+{
+#ifdef __APPLE__
+   static mach_timebase_info_data_t timeBaseInfo;
+   if(timeBaseInfo.denom == 0)
+   {
+      mach_timebase_info(&timeBaseInfo);
+   }
+   return mach_absolute_time() * timeBaseInfo.numer / timeBaseInfo.denom;
+#else
+   struct timespec now;
+   clock_gettime(CLOCK_MONOTONIC, &now);
+   return (uint64)now.tv_sec*1000000000ULL + now.tv_nsec;
+#endif
+}
+#endif
+
+/* Memory ordering helpers for the posted event queue.  These use the 
+ * GCC/Clang atomic builtins, which are available on all the platforms
+ * we care about (iOS, Android NDK, OS X).
+ */
+static inline uint32 LoadAcquire(const volatile uint32* value)
+{
+   return __atomic_load_n(value, __ATOMIC_ACQUIRE);
+}
+
+static inline void StoreRelease(volatile uint32* value, uint32 newValue)
+{
+   __atomic_store_n(value, newValue, __ATOMIC_RELEASE);
+}
+
+Notifier::Notifier() :
+   _notifyDepth(0),
+   _postEnqueuePos(0),
+   _postDequeuePos(0)
+{
+}
+
+Notifier::~Notifier()
+{
+   ReleaseObservers();
+}
+
+void Notifier::ReleaseObservers()
+{  // Anybody still attached has to forget about us.
+   for(uint32 event = 0; event < _notifiedVector.size(); event++)
+   {
+      NOTIFIED_VECTOR_T& notified = _notifiedVector[event];
+      for(uint32 idx = 0; idx < notified.size(); idx++)
+      {
+         if(notified[idx].observer != NULL)
+         {
+            notified[idx].observer->RemoveSlotIndices(this);
+         }
+      }
+   }
+}
 
 void Notifier::Reset()
 {
-   _notifiedMap.clear();
+   ReleaseObservers();
    _notifiedVector.clear();
    _notifiedVector.resize(NE_MAX);
-   _detached.clear();
+   _tombstones.clear();
+   _tombstones.resize(NE_MAX);
+   _unsorted.clear();
+   _unsorted.resize(NE_MAX);
    _notifyDepth = 0;
+   
+   // Anything still sitting in the post queue is thrown away.  This
+   // is NOT safe to do while other threads are posting.
+   assert((POST_QUEUE_SIZE & (POST_QUEUE_SIZE-1)) == 0);
+   _postQueue.resize(POST_QUEUE_SIZE);
+   for(uint32 idx = 0; idx < _postQueue.size(); idx++)
+   {
+      _postQueue[idx].sequence = idx;
+   }
+   _postEnqueuePos = 0;
+   _postDequeuePos = 0;
+   
+   _deliveryPolicy.clear();
+   _deliveryPolicy.resize(NE_MAX, DP_IMMEDIATE);
+   _heldEvents.clear();
+   _heldEvents.resize(NE_MAX);
+   _held.clear();
+   _held.resize(NE_MAX);
+   
+#ifdef NOTIFIER_STATS
+   ResetStats();
+#endif
+}
+
+void Notifier::Attach(Notified* observer, NOTIFIED_EVENT_TYPE_T eventType, int32 priority)
+{
+   AttachSlot(observer, eventType, NULL, NULL, priority);
+}
+
+void Notifier::AttachBatch(NotifiedBatch* observer, NOTIFIED_EVENT_TYPE_T eventType, int32 priority)
+{
+   AttachSlot(observer, eventType, NULL, observer == NULL ? NULL : &NotifyBatchVirtual, priority);
+}
+
+void Notifier::NotifyBatchVirtual(Notified* observer, NOTIFIED_EVENT_TYPE_T eventType, const void* items, uint32 itemSize, uint32 count)
+{
+   static_cast<NotifiedBatch*>(observer)->NotifyBatch(eventType, items, itemSize, count);
 }
 
-void Notifier::Attach(Notified* observer, NOTIFIED_EVENT_TYPE_T eventType)
+void Notifier::AttachSlot(Notified* observer, NOTIFIED_EVENT_TYPE_T eventType, NOTIFY_THUNK_T thunk, NOTIFY_BATCH_THUNK_T batchThunk, int32 priority)
 {
    if(observer == NULL)
    {
@@ -47,69 +153,137 @@ void Notifier::Attach(Notified* observer, NOTIFIED_EVENT_TYPE_T eventType)
       throw std::out_of_range("eventType out of range");
    }
    
-   _mapIter = _notifiedMap.find(observer);
-   if(_mapIter == _notifiedMap.end())
-   {  // Registering for the first time.
-      NOTIFIED_EVENT_TYPE_VECTOR_T eventTypes;
-      eventTypes.push_back(eventType);
-      // Register it with this observer.
-      _notifiedMap[observer] = eventTypes;
-      // Register the observer for this type of event.
-      _notifiedVector[eventType].push_back(observer);
+   NOTIFIED_SLOT_T slot;
+   slot.observer = observer;
+   slot.thunk = thunk;
+   slot.batchThunk = batchThunk;
+   slot.priority = priority;
+   
+   uint32* slotIndices = observer->FindSlotIndices(this);
+   if(slotIndices == NULL)
+   {  // First time attaching to this Notifier.
+      slotIndices = observer->AddSlotIndices(this);
+   }
+   if(slotIndices[eventType] == Notified::NOT_ATTACHED)
+   {  // Register the observer for this type of event.
+      InsertSlot(eventType, slot);
+   }
+   else
+   {  // Already registered.  Just update how it gets called.
+      NOTIFIED_SLOT_T& existing = _notifiedVector[eventType][slotIndices[eventType]];
+      assert(existing.observer == observer);
+      existing.thunk = thunk;
+      existing.batchThunk = batchThunk;
+   }
+}
+
+void Notifier::InsertSlot(NOTIFIED_EVENT_TYPE_T eventType, const NOTIFIED_SLOT_T& slot)
+{
+   NOTIFIED_VECTOR_T& notified = _notifiedVector[eventType];
+   
+   // Find the spot after everything with the same or higher priority.
+   // Searching from the end makes the usual case (everybody at the same
+   // priority) constant time.
+   uint32 insertAt = notified.size();
+   while(insertAt > 0 && notified[insertAt-1].priority < slot.priority)
+   {
+      insertAt--;
+   }
+   if(insertAt == notified.size())
+   {
+      notified.push_back(slot);
+      slot.observer->FindSlotIndices(this)[eventType] = insertAt;
+   }
+   else if(_notifyDepth > 0)
+   {  // Can't shift things around while a Notify(...) is walking the list.
+      // Add it to the end and sort it out later.
+      notified.push_back(slot);
+      slot.observer->FindSlotIndices(this)[eventType] = notified.size()-1;
+      _unsorted[eventType] = true;
    }
    else
+   {  // Everything after it moves down one.
+      notified.insert(notified.begin()+insertAt, slot);
+      UpdateSlotIndices(eventType, insertAt);
+   }
+}
+
+void Notifier::UpdateSlotIndices(NOTIFIED_EVENT_TYPE_T eventType, uint32 first)
+{
+   NOTIFIED_VECTOR_T& notified = _notifiedVector[eventType];
+   for(uint32 idx = first; idx < notified.size(); idx++)
    {
-      NOTIFIED_EVENT_TYPE_VECTOR_T& events = _mapIter->second;
-      bool found = false;
-      for(int idx = 0; idx < events.size() && !found; idx++)
+      if(notified[idx].observer != NULL)
       {
-         if(events[idx] == eventType)
-         {
-            found = true;
-            break;
-         }
+         notified[idx].observer->FindSlotIndices(this)[eventType] = idx;
       }
-      if(!found)
-      {
-         events.push_back(eventType);
-         _notifiedVector[eventType].push_back(observer);
-      }      
    }
 }
 
-void Notifier::RemoveEvent(NOTIFIED_EVENT_TYPE_VECTOR_T& eventTypes, NOTIFIED_EVENT_TYPE_T eventType)
+void Notifier::RemoveNotified(NOTIFIED_EVENT_TYPE_T eventType, Notified* observer)
 {
-   int foundAt = -1;
+   uint32* slotIndices = observer->FindSlotIndices(this);
+   if(slotIndices == NULL || slotIndices[eventType] == Notified::NOT_ATTACHED)
+   {  // Was not registered for this event.
+      return;
+   }
+   NOTIFIED_VECTOR_T& notified = _notifiedVector[eventType];
+   assert(notified[slotIndices[eventType]].observer == observer);
+   notified[slotIndices[eventType]].observer = NULL;
+   slotIndices[eventType] = Notified::NOT_ATTACHED;
+   _tombstones[eventType]++;
    
-   for(int idx = 0; idx < eventTypes.size(); idx++)
+   // If that was the last event, the observer is done with us.
+   bool attached = false;
+   for(uint32 event = NE_MIN; event < NE_MAX && !attached; event++)
    {
-      if(eventTypes[idx] == eventType)
-      {
-         foundAt = idx;
-         break;
-      }
+      attached = (slotIndices[event] != Notified::NOT_ATTACHED);
+   }
+   if(!attached)
+   {
+      observer->RemoveSlotIndices(this);
    }
-   if(foundAt >= 0)
+
+   if(_notifyDepth == 0 && _tombstones[eventType]*2 > notified.size())
    {
-      eventTypes.erase(eventTypes.begin()+foundAt);
+      CompactEvent(eventType);
    }
 }
 
-void Notifier::RemoveNotified(NOTIFIED_VECTOR_T& notified, Notified* observer)
+void Notifier::CompactEvent(NOTIFIED_EVENT_TYPE_T eventType)
 {
-   int foundAt = -1;
-   
-   for(int idx = 0; idx < notified.size(); idx++)
+   NOTIFIED_VECTOR_T& notified = _notifiedVector[eventType];
+   if(_unsorted[eventType])
+   {  // stable_sort keeps the attach order for equal priorities.  The
+      // tombstones get carried along and removed below.
+      std::stable_sort(notified.begin(), notified.end(), HigherPriority);
+      _unsorted[eventType] = false;
+   }
+   if(_tombstones[eventType] > 0)
    {
-      if(notified[idx] == observer)
+      uint32 kept = 0;
+      for(uint32 idx = 0; idx < notified.size(); idx++)
       {
-         foundAt = idx;
-         break;
+         if(notified[idx].observer != NULL)
+         {
+            notified[kept++] = notified[idx];
+         }
       }
+      notified.resize(kept);
+      _tombstones[eventType] = 0;
    }
-   if(foundAt >= 0)
-   {
-      notified.erase(notified.begin()+foundAt);
+   UpdateSlotIndices(eventType, 0);
+}
+
+void Notifier::CompactNotified()
+{
+   for(NOTIFIED_EVENT_TYPE_T event = NE_MIN; event < NE_MAX; event = (NOTIFIED_EVENT_TYPE_T)(event+1))
+   {  // Tombstones that were left below the threshold can stay; Notify(...)
+      // skips them.
+      if(_unsorted[event] || _tombstones[event]*2 > _notifiedVector[event].size())
+      {
+         CompactEvent(event);
+      }
    }
 }
 
@@ -125,22 +299,7 @@ void Notifier::Detach(Notified* observer, NOTIFIED_EVENT_TYPE_T eventType)
       throw std::out_of_range("eventType out of range");
    }
    
-   _mapIter = _notifiedMap.find(observer);
-   if(_mapIter != _notifiedMap.end())
-   {  // Was registered
-      // Remove it from the map.
-      RemoveEvent(_mapIter->second, eventType);
-      // Remove it from the vector
-      RemoveNotified(_notifiedVector[eventType], observer);
-      // If there are no events left, remove this observer completely.
-      if(_mapIter->second.size() == 0)
-      {
-         _notifiedMap.erase(_mapIter);
-         // If this observer was being removed during a chain of operations,
-         // cache them temporarily so we know the pointer is "dead".
-         _detached.push_back(observer);
-      }
-   }
+   RemoveNotified(eventType, observer);
 }
 
 void Notifier::Detach(Notified* observer)
@@ -150,27 +309,15 @@ void Notifier::Detach(Notified* observer)
       throw std::out_of_range("observer == NULL");
    }
    
-   _mapIter = _notifiedMap.find(observer);
-   if(_mapIter != _notifiedMap.end())
-   {
-      // These are all the event types this observer was registered for.
-      NOTIFIED_EVENT_TYPE_VECTOR_T& eventTypes = _mapIter->second;
-      for(int idx = 0; idx < eventTypes.size();idx++)
-      {  
-         NOTIFIED_EVENT_TYPE_T eventType = eventTypes[idx];
-         // Remove this observer from the Notified list for this event type.
-         RemoveNotified(_notifiedVector[eventType], observer);
-      }
-      _notifiedMap.erase(_mapIter);
+   for(NOTIFIED_EVENT_TYPE_T eventType = NE_MIN; eventType < NE_MAX; eventType = (NOTIFIED_EVENT_TYPE_T)(eventType+1))
+   {  // Remove this observer from the Notified list for this event type.
+      RemoveNotified(eventType, observer);
    }
-   // If this observer was being removed during a chain of operations,
-   // cache them temporarily so we know the pointer is "dead".
-   _detached.push_back(observer);
 }
 
 
 
-void Notifier::Notify(NOTIFIED_EVENT_TYPE_T eventType, const void* eventData)
+bool Notifier::Notify(NOTIFIED_EVENT_TYPE_T eventType, const void* eventData)
 {
    
    if(eventType < NE_MIN || eventType >= NE_MAX)
@@ -178,57 +325,339 @@ void Notifier::Notify(NOTIFIED_EVENT_TYPE_T eventType, const void* eventData)
       throw std::out_of_range("eventType out of range");
    }
    
-   // Keep a copy of the list.  If it changes while iterating over it because of a
-   // deletion, we may miss an object to update.  Instead, we keep track of Detach(...)
-   // calls during the Notify(...) cycle and ignore anything detached because it may
-   // have been deleted.
-   NOTIFIED_VECTOR_T notified = _notifiedVector[eventType];
+   // We walk the list in place.  Observers detached while we are walking
+   // it are tombstoned (set to NULL) instead of being removed, so the
+   // indices stay valid.  Observers attached while we are walking it are
+   // added at the end and we only go as far as the end of the list when we
+   // started, so they don't get this event (they weren't around when it was
+   // sent).  The vector may grow (and move) during the loop, so always index
+   // it instead of holding an iterator/pointer.
+   NOTIFIED_VECTOR_T& notified = _notifiedVector[eventType];
+   const uint32 count = notified.size();
 
    // If a call to Notify leads to a call to Notify, we need to keep track of
-   // the depth so that we can clear the detached list when we get to the end
+   // the depth so that we only compact the lists when we get to the end
    // of the chain of Notify calls.
    _notifyDepth++;
+#ifdef NOTIFIER_STATS
+   StatsDispatch(eventType);
+#endif
 
-   // Loop over all the observers for this event.
-   // NOTE that the the size of the notified vector may change if
-   // a call to Notify(...) adds/removes observers.  This should not be a
-   // problem because the list is a simple vector.
-   for(int idx = 0; idx < notified.size(); idx++)
-   {
-      Notified* observer = notified[idx];
-      if(_detached.size() > 0)
-      {  // Instead of doing the search for all cases, let's try to speed it up a little
-         // by only doing the search if more than one observer dropped off during the call.
-         // This may be overkill or unnecessary optimization.
-         switch(_detached.size())
-         {
-            case 0:
-               break;
-            case 1:
-               if(_detached[0] == observer)
-                  continue;
-               break;
-            default:
-               if(std::find(_detached.begin(), _detached.end(), observer) != _detached.end())
-                  continue;
+   // Loop over all the observers for this event, highest priority first,
+   // until somebody consumes it.
+   bool consumed = false;
+   for(uint32 idx = 0; idx < count && !consumed; idx++)
+   {
+      const NOTIFIED_SLOT_T& slot = notified[idx];
+      if(slot.observer == NULL)
+      {  // Tombstone.
+         continue;
+      }
+#ifdef NOTIFIER_STATS
+      uint64 callStart = StatsNanoseconds();
+#endif
+      if(slot.thunk != NULL)
+      {  // Typed observer, call the handler directly.
+         consumed = slot.thunk(slot.observer,eventType,eventData);
+      }
+      else
+      {
+         slot.observer->Notify(eventType,eventData);
+      }
+#ifdef NOTIFIER_STATS
+      StatsObserverCall(eventType, StatsNanoseconds() - callStart);
+#endif
+   }
+   // Decrement this each time we exit.
+   _notifyDepth--;
+   if(_notifyDepth == 0)
+   {  // We reached the end of the Notify call chain.  Clean out anything
+      // that detached while we were Notifying.
+      CompactNotified();
+   }
+   assert(_notifyDepth >= 0);
+   return consumed;
+}
+
+void Notifier::NotifyBatch(NOTIFIED_EVENT_TYPE_T eventType, const void* items, uint32 itemSize, uint32 count)
+{
+   if(eventType < NE_MIN || eventType >= NE_MAX)
+   {
+      throw std::out_of_range("eventType out of range");
+   }
+   if(count > 0 && (items == NULL || itemSize == 0))
+   {
+      throw std::out_of_range("items == NULL or itemSize == 0");
+   }
+   
+   // This follows the same rules as Notify(...) for walking the list.
+   NOTIFIED_VECTOR_T& notified = _notifiedVector[eventType];
+   const uint32 observers = notified.size();
+   const uint8* itemBytes = (const uint8*)items;
+   
+   _notifyDepth++;
+#ifdef NOTIFIER_STATS
+   StatsDispatch(eventType);
+#endif
+   
+   for(uint32 idx = 0; idx < observers; idx++)
+   {
+      if(notified[idx].observer == NULL)
+      {  // Tombstone.
+         continue;
+      }
+#ifdef NOTIFIER_STATS
+      uint64 callStart = StatsNanoseconds();
+#endif
+      if(notified[idx].batchThunk != NULL)
+      {  // Takes the whole batch at once.
+         notified[idx].batchThunk(notified[idx].observer, eventType, items, itemSize, count);
+      }
+      else
+      {
+         for(uint32 item = 0; item < count; item++)
+         {  // The observer could detach (or be deleted) on any item, so
+            // check the slot every time.
+            const NOTIFIED_SLOT_T& slot = notified[idx];
+            if(slot.observer == NULL)
+            {
                break;
+            }
+            if(slot.thunk != NULL)
+            {
+               slot.thunk(slot.observer, eventType, itemBytes + item*itemSize);
+            }
+            else
+            {
+               slot.observer->Notify(eventType, itemBytes + item*itemSize);
+            }
          }
       }
-      observer->Notify(eventType,eventData);
+#ifdef NOTIFIER_STATS
+      // One observer's share of the batch counts as one call.
+      StatsObserverCall(eventType, StatsNanoseconds() - callStart);
+#endif
    }
-   // Decrement this each time we exit.
+   
    _notifyDepth--;
-   if(_notifyDepth == 0 && _detached.size() > 0)
-   {  // We reached the end of the Notify call chain.  Remove the temporary list
-      // of anything that detached while we were Notifying.
-      _detached.clear();
+   if(_notifyDepth == 0)
+   {
+      CompactNotified();
    }
    assert(_notifyDepth >= 0);
 }
 
-Notified::~Notified()
+bool Notifier::Post(NOTIFIED_EVENT_TYPE_T eventType, const void* eventData, uint32 eventDataSize)
 {
-   Notifier::Instance().Detach(this);
+   if(eventType < NE_MIN || eventType >= NE_MAX)
+   {
+      throw std::out_of_range("eventType out of range");
+   }
+   if(eventDataSize > POST_PAYLOAD_SIZE_MAX)
+   {
+      throw std::out_of_range("eventDataSize > POST_PAYLOAD_SIZE_MAX");
+   }
+   if(eventDataSize > 0 && eventData == NULL)
+   {
+      throw std::out_of_range("eventData == NULL");
+   }
+   if(_postQueue.size() == 0)
+   {  // Init() has not been called yet.
+      return false;
+   }
+   
+   const uint32 mask = POST_QUEUE_SIZE-1;
+   POSTED_EVENT_T* slot;
+   uint32 pos = LoadAcquire(&_postEnqueuePos);
+   for(;;)
+   {
+      slot = &_postQueue[pos & mask];
+      int32 diff = (int32)(LoadAcquire(&slot->sequence) - pos);
+      if(diff == 0)
+      {  // The slot is free.  Try to claim it.
+         if(__sync_bool_compare_and_swap(&_postEnqueuePos, pos, pos+1))
+            break;
+         pos = LoadAcquire(&_postEnqueuePos);
+      }
+      else if(diff < 0)
+      {  // The consumer has not freed this slot yet...the queue is full.
+         return false;
+      }
+      else
+      {  // Another producer got this slot first.  Try the next one.
+         pos = LoadAcquire(&_postEnqueuePos);
+      }
+   }
+   
+   // The slot is ours until we bump the sequence number.
+   slot->eventType = eventType;
+   slot->eventDataSize = eventDataSize;
+   if(eventDataSize > 0)
+   {
+      memcpy(slot->payload.bytes, eventData, eventDataSize);
+      slot->eventData = NULL;
+   }
+   else
+   {
+      slot->eventData = eventData;
+   }
+   // Publish it to the consumer.
+   StoreRelease(&slot->sequence, pos+1);
+   return true;
+}
+
+uint32 Notifier::DispatchPending(uint32 budget)
+{
+   if(_postQueue.size() == 0)
+   {  // Init() has not been called yet.
+      return 0;
+   }
+   
+   const uint32 mask = POST_QUEUE_SIZE-1;
+   // Only deliver what was in the queue when we started.  Otherwise an
+   // observer that posts an event in response to an event could keep us
+   // here forever.
+   uint32 available = LoadAcquire(&_postEnqueuePos) - _postDequeuePos;
+   if(budget == 0 || budget > available)
+   {
+      budget = available;
+   }
+   
+   uint32 taken = 0;
+   uint32 dispatched = 0;
+   POSTED_EVENT_T event;
+   while(taken < budget)
+   {
+      POSTED_EVENT_T& slot = _postQueue[_postDequeuePos & mask];
+      int32 diff = (int32)(LoadAcquire(&slot.sequence) - (_postDequeuePos+1));
+      if(diff < 0)
+      {  // A producer has claimed the slot but has not finished writing
+         // it yet.  Pick it up next time.
+         break;
+      }
+      // Copy it out and hand the slot back to the producers BEFORE calling
+      // the observers, so they are free to post more events.
+      CopyPostedEvent(event, slot);
+      StoreRelease(&slot.sequence, _postDequeuePos + mask + 1);
+      _postDequeuePos++;
+      taken++;
+      
+      if(_deliveryPolicy[event.eventType] == DP_IMMEDIATE)
+      {
+         Notify(event.eventType, event.eventData);
+         dispatched++;
+      }
+      else
+      {
+         HoldEvent(event);
+      }
+   }
+   
+   // Now the ones that were collapsed.  Release each one before delivering
+   // it, so an observer can post it again for the next frame.
+   for(int32 eventType = NE_MIN; eventType < NE_MAX; eventType++)
+   {
+      if(_held[eventType])
+      {
+         CopyPostedEvent(event, _heldEvents[eventType]);
+         _held[eventType] = false;
+         Notify(event.eventType, event.eventData);
+         dispatched++;
+      }
+   }
+   return dispatched;
+}
+
+void Notifier::HoldEvent(const POSTED_EVENT_T& event)
+{
+   if(_held[event.eventType] && _deliveryPolicy[event.eventType] == DP_COALESCE)
+   {  // Keep the first one.
+      return;
+   }
+   CopyPostedEvent(_heldEvents[event.eventType], event);
+   _held[event.eventType] = true;
+}
+
+void Notifier::CopyPostedEvent(POSTED_EVENT_T& to, const POSTED_EVENT_T& from)
+{
+   to.eventType = from.eventType;
+   to.eventData = from.eventData;
+   to.eventDataSize = from.eventDataSize;
+   if(from.eventDataSize > 0)
+   {
+      memcpy(to.payload.bytes, from.payload.bytes, from.eventDataSize);
+      to.eventData = to.payload.bytes;
+   }
+}
+
+void Notifier::SetDeliveryPolicy(NOTIFIED_EVENT_TYPE_T eventType, DELIVERY_POLICY_T policy)
+{
+   if(eventType < NE_MIN || eventType >= NE_MAX)
+   {
+      throw std::out_of_range("eventType out of range");
+   }
+   if(policy < DP_IMMEDIATE || policy > DP_LAST_VALUE)
+   {
+      throw std::out_of_range("policy out of range");
+   }
+   _deliveryPolicy[eventType] = policy;
+}
+
+Notifier::DELIVERY_POLICY_T Notifier::GetDeliveryPolicy(NOTIFIED_EVENT_TYPE_T eventType) const
+{
+   if(eventType < NE_MIN || eventType >= NE_MAX)
+   {
+      throw std::out_of_range("eventType out of range");
+   }
+   return _deliveryPolicy[eventType];
+}
+
+const uint32 Notified::NOT_ATTACHED;
+
+uint32* Notified::FindSlotIndices(const Notifier* notifier)
+{
+   for(uint32 idx = 0; idx < _memberships.size(); idx++)
+   {
+      if(_memberships[idx].notifier == notifier)
+      {
+         return _memberships[idx].slotIndex;
+      }
+   }
+   return NULL;
+}
+
+uint32* Notified::AddSlotIndices(Notifier* notifier)
+{
+   assert(FindSlotIndices(notifier) == NULL);
+   MEMBERSHIP_T membership;
+   membership.notifier = notifier;
+   for(uint32 event = 0; event < Notifier::NE_MAX; event++)
+   {
+      membership.slotIndex[event] = NOT_ATTACHED;
+   }
+   _memberships.push_back(membership);
+   return _memberships.back().slotIndex;
+}
+
+void Notified::RemoveSlotIndices(const Notifier* notifier)
+{
+   for(uint32 idx = 0; idx < _memberships.size(); idx++)
+   {
+      if(_memberships[idx].notifier == notifier)
+      {
+         _memberships.erase(_memberships.begin()+idx);
+         return;
+      }
+   }
+}
+
+Notified::~Notified()
+{  // Detaching from all events removes the membership, so this
+   // always gets shorter.
+   while(!_memberships.empty())
+   {
+      _memberships.back().notifier->Detach(this);
+   }
 }
 
 // Return all events that this object is registered for.
@@ -236,11 +665,21 @@ vector<Notifier::NOTIFIED_EVENT_TYPE_T> Notifier::GetEvents(Notified* observer)
 {
    vector<Notifier::NOTIFIED_EVENT_TYPE_T> result;
    
-   _mapIter = _notifiedMap.find(observer);
-   if(_mapIter != _notifiedMap.end())
+   if(observer == NULL)
+   {
+      return result;
+   }
+   const uint32* slotIndices = observer->FindSlotIndices(this);
+   if(slotIndices == NULL)
    {
-      // These are all the event types this observer was registered for.
-      result = _mapIter->second;
+      return result;
+   }
+   for(NOTIFIED_EVENT_TYPE_T event = NE_MIN; event < NE_MAX; event = (NOTIFIED_EVENT_TYPE_T)(event+1))
+   {
+      if(slotIndices[event] != Notified::NOT_ATTACHED)
+      {
+         result.push_back(event);
+      }
    }
 
    return result;
@@ -249,6 +688,82 @@ vector<Notifier::NOTIFIED_EVENT_TYPE_T> Notifier::GetEvents(Notified* observer)
 // Return all objects registered for this event.
 vector<Notified*> Notifier::GetNotified(NOTIFIED_EVENT_TYPE_T event)
 {
-   return _notifiedVector[event];
+   vector<Notified*> result;
+   const NOTIFIED_VECTOR_T& notified = _notifiedVector[event];
+   for(uint32 idx = 0; idx < notified.size(); idx++)
+   {  // Leave out any tombstones if we are in the middle of a Notify(...).
+      if(notified[idx].observer != NULL)
+      {
+         result.push_back(notified[idx].observer);
+      }
+   }
+   return result;
 }
 
+
+#ifdef NOTIFIER_STATS
+void Notifier::StatsDispatch(NOTIFIED_EVENT_TYPE_T eventType)
+{
+   EVENT_STATS_T& stats = _stats[eventType];
+   stats.dispatches++;
+   if(_notifyDepth > stats.maxDepth)
+   {
+      stats.maxDepth = _notifyDepth;
+   }
+}
+
+void Notifier::StatsObserverCall(NOTIFIED_EVENT_TYPE_T eventType, uint64 nanoseconds)
+{
+   EVENT_STATS_T& stats = _stats[eventType];
+   stats.observersCalled++;
+   stats.callNanoseconds += nanoseconds;
+   // The bucket is the position of the highest bit set.
+   uint32 bucket = 0;
+   while(nanoseconds > 1 && bucket < STATS_HISTOGRAM_BUCKETS-1)
+   {
+      nanoseconds >>= 1;
+      bucket++;
+   }
+   stats.histogram[bucket]++;
+}
+
+const Notifier::EVENT_STATS_T& Notifier::GetStats(NOTIFIED_EVENT_TYPE_T eventType) const
+{
+   if(eventType < NE_MIN || eventType >= NE_MAX)
+   {
+      throw std::out_of_range("eventType out of range");
+   }
+   return _stats[eventType];
+}
+
+void Notifier::ResetStats()
+{
+   memset(_stats, 0, sizeof(_stats));
+}
+
+void Notifier::DumpStats(ostream& out) const
+{
+   out << "Notifier Stats" << endl;
+   out << setw(6) << "Event" << setw(12) << "Dispatches" << setw(12) << "Calls" << setw(10) << "MaxDepth" << setw(14) << "Total(us)" << setw(12) << "Avg(ns)" << endl;
+   for(int32 event = NE_MIN; event < NE_MAX; event++)
+   {
+      const EVENT_STATS_T& stats = _stats[event];
+      if(stats.dispatches == 0)
+      {
+         continue;
+      }
+      uint64 average = stats.observersCalled > 0 ? stats.callNanoseconds/stats.observersCalled : 0;
+      out << setw(6) << event << setw(12) << stats.dispatches << setw(12) << stats.observersCalled << setw(10) << stats.maxDepth << setw(14) << stats.callNanoseconds/1000 << setw(12) << average << endl;
+      // Only the buckets that were used.
+      out << "       ns histogram:";
+      for(uint32 bucket = 0; bucket < STATS_HISTOGRAM_BUCKETS; bucket++)
+      {
+         if(stats.histogram[bucket] > 0)
+         {
+            out << " [" << (1ULL << bucket) << "]=" << stats.histogram[bucket];
+         }
+      }
+      out << endl;
+   }
+}
+#endif
@@ -30,6 +30,15 @@
 #include "CommonSTL.h"
 #include "SingletonTemplate.h"
 
+// Uncomment this (or define it in the build settings) to collect
+// per-event dispatch statistics.  See "Statistics" below.
+//#define NOTIFIER_STATS
+
+// The statistics never make it into a release build.
+#if defined(NOTIFIER_STATS) && defined(NDEBUG)
+#undef NOTIFIER_STATS
+#endif
+
 /* 
  The Notifier is a singleton implementation of the Subject/Observer design
  pattern.  Any class/instance which wishes to participate as an observer
@@ -61,10 +70,96 @@
  mutex wrappers.  It is safe to call Attach/Detach as a consequence 
  of calling Notify(...).  
  
+ The one exception is Post(...).  Any thread may call Post(...) to queue
+ an event for later delivery.  The queue is a bounded lock-free ring 
+ buffer (multiple producers, single consumer).  The main thread calls
+ DispatchPending(...) once per frame to deliver the queued events through
+ the normal Notify(...) path, so observers only ever get called on the 
+ main thread.  If the queue is full, Post(...) returns false and the
+ event is dropped; it is up to the caller to decide if that matters.
+ 
+ Delivery Policies
+ -----------------
+ Some events only need to happen once per frame no matter how many times
+ they are posted (e.g. NE_RESET_DRAW_CYCLE).  SetDeliveryPolicy(...) 
+ changes how posted events of a given type are delivered:
+   DP_IMMEDIATE  - Every post is delivered, in order (the default).
+   DP_COALESCE   - All the posts in one DispatchPending(...) are delivered
+                   once, with the payload of the first one.
+   DP_LAST_VALUE - Same, but with the payload of the last one.
+ Coalesced events are held until the end of DispatchPending(...) and 
+ delivered after the DP_IMMEDIATE ones, in event type order.  This only
+ applies to Post(...); Notify(...) always delivers right away.
+ 
+ Typed Channels
+ --------------
+ Each event type has a payload type fixed at compile time (see
+ Notifier::EventPayload below).  Instead of overriding Notify(...) and
+ switching on the event type, a NotifiedTyped derived class can attach a 
+ member function for a single event through a Channel:
+ 
+ Notifier::Channel<Notifier::NE_DEBUG_BUTTON_PRESSED>().Attach<MainScene,&MainScene::DebugButtonPressed>(this);
+ ...
+ Notifier::Channel<Notifier::NE_DEBUG_BUTTON_PRESSED>().Notify(buttonTag);
+ 
+ The member function is called directly (no virtual call, no switch) and
+ sending or receiving the wrong payload type is a compile error.  Typed
+ and untyped observers can be mixed on the same event; the untyped ones
+ get a pointer to the payload as their eventData.
+ 
+ Batches
+ -------
+ Some events are sent many times in a row (e.g. one per line segment).
+ NotifyBatch(...) sends an array of payloads in one call.  Observers that
+ opt in (derive from NotifiedBatch and use AttachBatch(...), or use
+ Channel::AttachBatch(...)) get
+ the whole array in one call.  Everyone else gets one Notify(...) per item,
+ same as if the items had been sent one at a time.  Each observer gets all
+ the items before the next observer gets any.
+ 
+ Priority and Consuming Events
+ -----------------------------
+ Observers can be attached with a priority.  Higher priorities are called
+ first; observers with the same priority are called in the order they 
+ were attached.  A typed handler that returns bool can "consume" an event
+ by returning true, in which case nobody after it gets the event (this is
+ handy for input, where only one observer should act on a touch).  
+ Consuming only applies to single events, not batches.  To change an
+ observer's priority, Detach(...) and Attach(...) it again.
+ 
+ Multiple Notifiers
+ ------------------
+ Notifier::Instance() is the default, and everything that doesn't say 
+ otherwise uses it.  A scene, layer or worker that wants its own observers
+ can own a Notifier of its own, so dispatching its events never walks 
+ anybody else's observers.  A Notified can be attached to any number of 
+ Notifiers and detaches from all of them when it is destroyed.  A Channel
+ takes the Notifier to use:
+ 
+ Notifier::Channel<Notifier::NE_RESET_DRAW_CYCLE>(_sceneNotifier).Notify();
+ 
+ Statistics
+ ----------
+ When NOTIFIER_STATS is defined (and NDEBUG is not), the Notifier keeps 
+ these for each event type:
+   - How many times it was dispatched (a batch counts once).
+   - How many observer calls were made for it.
+   - The deepest nesting of Notify(...) calls it was dispatched at.
+   - How long the observer calls took, in log2 nanosecond buckets.  The
+     time for a call includes everything the observer did, including any
+     Notify(...) calls it made.
+ Use GetStats(...), DumpStats(...) and ResetStats() to look at them.  
+ Otherwise, none of this is compiled in.
+ 
  */
 
 
 class Notified;
+class NotifiedBatch;
+
+// Payload types that live in the main project.  Only pointers/references
+// to these are needed here, so CppUnitTest does not need cocos2d.
+struct LINE_PIXELS_DATA;
 
 class Notifier : public SingletonDynamic<Notifier>
 {
@@ -79,37 +174,174 @@ public:
       NE_MAX,
    } NOTIFIED_EVENT_TYPE_T;
    
+   // When you add an event, add an EventPayload specialization for it
+   // (at the bottom of this file) or it cannot be used with a Channel.
+   template<NOTIFIED_EVENT_TYPE_T EVENT> struct EventPayload;
+   template<NOTIFIED_EVENT_TYPE_T EVENT> class Channel;
+   
+   // Payload type for events that don't carry any data.
+   typedef struct {} NO_PAYLOAD_T;
+   
+   // Typed observers are called through one of these.  The Channel
+   // generates one for each handler member function.  Returns true if
+   // the observer consumed the event.
+   typedef bool (*NOTIFY_THUNK_T)(Notified* observer, NOTIFIED_EVENT_TYPE_T eventType, const void* eventData);
+   typedef void (*NOTIFY_BATCH_THUNK_T)(Notified* observer, NOTIFIED_EVENT_TYPE_T eventType, const void* items, uint32 itemSize, uint32 count);
+   
+   typedef enum
+   {
+      DP_IMMEDIATE,
+      DP_COALESCE,
+      DP_LAST_VALUE,
+   } DELIVERY_POLICY_T;
+   
+   enum
+   {
+      // Number of slots in the posted event queue.  MUST be a power of 2.
+      POST_QUEUE_SIZE = 1024,
+      // Largest payload (in bytes) that Post(...) will copy into the queue.
+      POST_PAYLOAD_SIZE_MAX = 64,
+   };
+   
+#ifdef NOTIFIER_STATS
+   enum
+   {
+      // Bucket b counts observer calls that took [2^b, 2^(b+1)) ns.  Bucket
+      // 0 also gets calls too fast to measure, the last one everything
+      // over ~1 second.
+      STATS_HISTOGRAM_BUCKETS = 31,
+   };
+   
+   typedef struct
+   {
+      uint64 dispatches;
+      uint64 observersCalled;
+      int32 maxDepth;
+      uint64 callNanoseconds;
+      uint32 histogram[STATS_HISTOGRAM_BUCKETS];
+   } EVENT_STATS_T;
+#endif
+   
 private:
-   typedef vector<NOTIFIED_EVENT_TYPE_T> NOTIFIED_EVENT_TYPE_VECTOR_T;
+   // An observer registered for an event.  If thunk is NULL, this is an
+   // untyped observer and gets the virtual Notified::Notify(...) call.
+   // If batchThunk is not NULL, the observer takes batches in one call.
+   typedef struct
+   {
+      Notified* observer;
+      NOTIFY_THUNK_T thunk;
+      NOTIFY_BATCH_THUNK_T batchThunk;
+      int32 priority;
+   } NOTIFIED_SLOT_T;
    
-   typedef map<Notified*,NOTIFIED_EVENT_TYPE_VECTOR_T> NOTIFIED_MAP_T;
-   typedef map<Notified*,NOTIFIED_EVENT_TYPE_VECTOR_T>::iterator NOTIFIED_MAP_ITER_T;
+   // For sorting slots by priority (highest first).
+   static bool HigherPriority(const NOTIFIED_SLOT_T& lhs, const NOTIFIED_SLOT_T& rhs) { return lhs.priority > rhs.priority; }
    
-   typedef vector<Notified*> NOTIFIED_VECTOR_T;
+   typedef vector<NOTIFIED_SLOT_T> NOTIFIED_VECTOR_T;
    typedef vector<NOTIFIED_VECTOR_T> NOTIFIED_VECTOR_VECTOR_T;
    
-   NOTIFIED_MAP_T _notifiedMap;
+   // Each observer keeps the index of its slot in each of these lists
+   // (see Notified), so finding an observer is never a search.
    NOTIFIED_VECTOR_VECTOR_T _notifiedVector;
-   NOTIFIED_MAP_ITER_T _mapIter;
-
-   // This vector keeps a temporary list of observers that have completely
-   // detached since the current "Notify(...)" operation began.  This is
-   // to handle the problem where a Notified instance has called Detach(...)
-   // because of a Notify(...) call.  The removed instance could be a dead
-   // pointer, so don't try to talk to it.
-   vector<Notified*> _detached;
+
+   // Detaching an observer sets its slot's observer to NULL (a "tombstone")
+   // instead of erasing it.  This keeps the indices of every other slot 
+   // valid, both for the observers and for a Notify(...) that may be
+   // walking the list, and makes Detach(...) constant time.  A list is
+   // compacted once half of it is tombstones (and never while a Notify(...)
+   // is in progress), so the cost is spread over the Detach(...) calls 
+   // even when thousands of observers go away at once.  This keeps the
+   // count of tombstones for each event type.
+   vector<uint32> _tombstones;
+   // Observers attached during a Notify(...) are always added at the end
+   // so they don't disturb the walk.  If that puts a list out of priority
+   // order, it is flagged here and sorted when the tombstones are cleaned up.
+   vector<bool> _unsorted;
    int32 _notifyDepth;
    
-   void RemoveEvent(NOTIFIED_EVENT_TYPE_VECTOR_T& orgEventTypes, NOTIFIED_EVENT_TYPE_T eventType);
-   void RemoveNotified(NOTIFIED_VECTOR_T& orgNotified, Notified* observer);
+   void CompactNotified();
+   // Remove the tombstones and/or sort one list and fix up the indices
+   // the observers hold.
+   void CompactEvent(NOTIFIED_EVENT_TYPE_T eventType);
+   // Point each observer in a list at its slot, starting at first.
+   void UpdateSlotIndices(NOTIFIED_EVENT_TYPE_T eventType, uint32 first);
+   // Make every attached observer forget about this Notifier.
+   void ReleaseObservers();
+   
+   // Observers hold a pointer to the Notifier, so it cannot be copied.
+   Notifier(const Notifier& other);
+   Notifier& operator=(const Notifier& other);
+   
+   // A single slot in the posted event queue.  The sequence number is
+   // used by the producers and the consumer to figure out who owns the
+   // slot (see Dmitry Vyukov's bounded MPMC queue, which this is a
+   // single consumer version of).
+   typedef struct
+   {
+      volatile uint32 sequence;
+      NOTIFIED_EVENT_TYPE_T eventType;
+      const void* eventData;
+      uint32 eventDataSize;
+      union
+      {
+         uint8 bytes[POST_PAYLOAD_SIZE_MAX];
+         // Force the alignment so any POD payload can be copied in/out.
+         float64 alignFloat64;
+         int64 alignInt64;
+         void* alignPtr;
+      } payload;
+   } POSTED_EVENT_T;
+   
+   vector<POSTED_EVENT_T> _postQueue;
+   // Written by the posting threads.  Kept on a different cache line
+   // than the dequeue position, which only the main thread touches.
+   volatile uint32 _postEnqueuePos;
+   uint8 _postPad[64];
+   uint32 _postDequeuePos;
+   
+   // Posted events that are not DP_IMMEDIATE are held here (one per
+   // event type) until the end of DispatchPending(...).
+   vector<DELIVERY_POLICY_T> _deliveryPolicy;
+   vector<POSTED_EVENT_T> _heldEvents;
+   vector<bool> _held;
+   
+   void HoldEvent(const POSTED_EVENT_T& event);
+   // Copy a posted event, pointing eventData at the copy of the payload.
+   static void CopyPostedEvent(POSTED_EVENT_T& to, const POSTED_EVENT_T& from);
+   
+#ifdef NOTIFIER_STATS
+   EVENT_STATS_T _stats[NE_MAX];
+   
+   void StatsDispatch(NOTIFIED_EVENT_TYPE_T eventType);
+   void StatsObserverCall(NOTIFIED_EVENT_TYPE_T eventType, uint64 nanoseconds);
+#endif
+   
+   void RemoveNotified(NOTIFIED_EVENT_TYPE_T eventType, Notified* observer);
+   void InsertSlot(NOTIFIED_EVENT_TYPE_T eventType, const NOTIFIED_SLOT_T& slot);
+   // Used by Attach(...) and Channel::Attach(...).
+   void AttachSlot(Notified* observer, NOTIFIED_EVENT_TYPE_T eventType, NOTIFY_THUNK_T thunk, NOTIFY_BATCH_THUNK_T batchThunk, int32 priority);
+   // Used for observers attached as a NotifiedBatch.
+   static void NotifyBatchVirtual(Notified* observer, NOTIFIED_EVENT_TYPE_T eventType, const void* items, uint32 itemSize, uint32 count);
    
 public:
    
+   /* Instance() is the default Notifier and is what everything uses unless
+    * told otherwise.  Others can be created for a scene, layer, worker,
+    * etc. that wants its own set of observers, so its events don't pay for
+    * everybody else's (and vice versa).  They follow the same life cycle:
+    * call Init() before using one.  Destroying a Notifier detaches all its
+    * observers.
+    */
+   Notifier();
+   virtual ~Notifier();
+   
    virtual void Reset();
    virtual bool Init() { Reset(); return true; }
    virtual void Shutdown() { Reset(); }
    
-   void Attach(Notified* observer, NOTIFIED_EVENT_TYPE_T eventType);
+   void Attach(Notified* observer, NOTIFIED_EVENT_TYPE_T eventType, int32 priority = 0);
+   // Same as above, but the observer gets batches in a single call.
+   void AttachBatch(NotifiedBatch* observer, NOTIFIED_EVENT_TYPE_T eventType, int32 priority = 0);
    // Detach for a specific event
    void Detach(Notified* observer, NOTIFIED_EVENT_TYPE_T eventType);
    // Detach for ALL events
@@ -122,8 +354,50 @@ public:
     * object to be used and make sure it updated the passed in
     * object when a member is added to it.  This way, a break
     * occurs at compile time that must be addressed.
+    *
+    * Returns true if an observer consumed the event.
+    */
+   bool Notify(NOTIFIED_EVENT_TYPE_T, const void* eventData = NULL);
+   
+   /* Send count payloads, each itemSize bytes, packed in an array.  See
+    * "Batches" above.  The typed version figures out itemSize for you.
+    */
+   void NotifyBatch(NOTIFIED_EVENT_TYPE_T eventType, const void* items, uint32 itemSize, uint32 count);
+   template<class T>
+   void NotifyBatch(NOTIFIED_EVENT_TYPE_T eventType, const T* items, uint32 count)
+   {
+      NotifyBatch(eventType, items, sizeof(T), count);
+   }
+   
+   /* Queue an event for delivery on the next call to DispatchPending(...).
+    * This may be called from ANY thread.
+    *
+    * If eventDataSize is 0, eventData is passed through to the observers
+    * as is (same as Notify(...)), so it had better still be valid when
+    * the event is dispatched.  Otherwise, eventDataSize bytes are copied
+    * into the queue (up to POST_PAYLOAD_SIZE_MAX) and the observers get
+    * a pointer to the copy.  The copy only lives for the duration of the
+    * Notify(...) call, so plain old data only.
+    *
+    * Returns false if the queue is full (the event is NOT queued).
     */
-   void Notify(NOTIFIED_EVENT_TYPE_T, const void* eventData = NULL);
+   bool Post(NOTIFIED_EVENT_TYPE_T eventType, const void* eventData = NULL, uint32 eventDataSize = 0);
+   
+   /* Deliver events queued by Post(...).  This MUST only be called from
+    * the main thread (the same one that calls Notify(...)), usually once
+    * per frame.  At most budget events are taken from the queue.  A budget
+    * of 0 means take everything that was queued when the call started; 
+    * events posted while dispatching wait for the next call.  Coalesced 
+    * events (see "Delivery Policies" above) are delivered at the end.
+    *
+    * Returns the number of events delivered.
+    */
+   uint32 DispatchPending(uint32 budget = 0);
+   
+   // How posted events of this type are delivered.  Reset() sets every
+   // event back to DP_IMMEDIATE.
+   void SetDeliveryPolicy(NOTIFIED_EVENT_TYPE_T eventType, DELIVERY_POLICY_T policy);
+   DELIVERY_POLICY_T GetDeliveryPolicy(NOTIFIED_EVENT_TYPE_T eventType) const;
    
    /* Used for CPPUnit.  Could create a Mock...maybe...but this seems
     * like it will get the job done with minimal fuss.  For now.
@@ -132,17 +406,196 @@ public:
    vector<NOTIFIED_EVENT_TYPE_T> GetEvents(Notified* observer);
    // Return all objects registered for this event.
    vector<Notified*> GetNotified(NOTIFIED_EVENT_TYPE_T event);
+   
+#ifdef NOTIFIER_STATS
+   const EVENT_STATS_T& GetStats(NOTIFIED_EVENT_TYPE_T eventType) const;
+   void ResetStats();
+   // Write a table of the statistics for every event that was dispatched.
+   void DumpStats(ostream& out) const;
+#endif
 };
 
 /* This is the base class for anything that can receive notifications.
+ * Classes that only attach through a Channel derive from NotifiedTyped
+ * instead, so they don't have to override Notify(...).
  */
 class Notified
 {
+private:
+   friend class Notifier;
+   
+   static const uint32 NOT_ATTACHED = 0xFFFFFFFF;
+   
+   // The index of this observer's slot in one Notifier's list for
+   // each event, or NOT_ATTACHED.  Only the Notifier touches these.
+   typedef struct
+   {
+      Notifier* notifier;
+      uint32 slotIndex[Notifier::NE_MAX];
+   } MEMBERSHIP_T;
+   
+   // One for each Notifier this observer is attached to.  There are 
+   // rarely more than one or two, so they are searched.
+   vector<MEMBERSHIP_T> _memberships;
+   
+   // Returns NULL if not attached to notifier.
+   uint32* FindSlotIndices(const Notifier* notifier);
+   uint32* AddSlotIndices(Notifier* notifier);
+   void RemoveSlotIndices(const Notifier* notifier);
+   
 public:
+   Notified() {}
+   // A copy is not attached to anything, and assigning one observer to
+   // another does not change what either one is attached to.
+   Notified(const Notified& other) {}
+   Notified& operator=(const Notified& other) { return *this; }
+   
    virtual void Notify(Notifier::NOTIFIED_EVENT_TYPE_T eventType, const void* eventData) = 0;
+   // Detaches from every Notifier it is attached to.
    virtual ~Notified();
 
 };
 
+/* Derive from this instead of Notified when every event is received
+ * through a Channel.  Channels call the attached member function
+ * directly, so Notify(...) is never called.
+ */
+class NotifiedTyped : public Notified
+{
+private:
+   // If you get here, this was attached with Notifier::Attach(...),
+   // which needs a Notified that overrides Notify(...).
+   virtual void Notify(Notifier::NOTIFIED_EVENT_TYPE_T eventType, const void* eventData) { assert(false); }
+};
+
+/* Derive from this instead of Notified to receive a NotifyBatch(...)
+ * in one call instead of one Notify(...) per item.  Single events still
+ * come through Notify(...).
+ */
+class NotifiedBatch : public Notified
+{
+public:
+   virtual void NotifyBatch(Notifier::NOTIFIED_EVENT_TYPE_T eventType, const void* items, uint32 itemSize, uint32 count) = 0;
+};
+
+/* The payload type for each event.  There is deliberately no general
+ * definition, so using a Channel for an event that has not been given
+ * a payload type here will not compile.
+ */
+template<> struct Notifier::EventPayload<Notifier::NE_DEBUG_BUTTON_PRESSED> { typedef uint32 PAYLOAD_T; };
+template<> struct Notifier::EventPayload<Notifier::NE_DEBUG_LINE_DRAW_ADD_LINE_PIXELS> { typedef LINE_PIXELS_DATA PAYLOAD_T; };
+template<> struct Notifier::EventPayload<Notifier::NE_DEBUG_LINES_TOGGLE_VISIBILITY> { typedef NO_PAYLOAD_T PAYLOAD_T; };
+template<> struct Notifier::EventPayload<Notifier::NE_RESET_DRAW_CYCLE> { typedef NO_PAYLOAD_T PAYLOAD_T; };
+
+/* Turn the eventData from an untyped Notify(...) call back into a
+ * payload reference.  Events without a payload are usually sent with
+ * eventData == NULL, so those don't touch it at all.
+ */
+template<class PAYLOAD_T>
+inline const PAYLOAD_T& NotifierPayloadRef(const void* eventData)
+{
+   assert(eventData != NULL);
+   return *static_cast<const PAYLOAD_T*>(eventData);
+}
+
+template<>
+inline const Notifier::NO_PAYLOAD_T& NotifierPayloadRef<Notifier::NO_PAYLOAD_T>(const void* eventData)
+{
+   static const Notifier::NO_PAYLOAD_T noPayload = Notifier::NO_PAYLOAD_T();
+   return noPayload;
+}
+
+/* A typed view of a single event on a Notifier.  These are cheap to 
+ * create (it is just a reference to the Notifier), so create them where
+ * you need them.
+ */
+template<Notifier::NOTIFIED_EVENT_TYPE_T EVENT>
+class Notifier::Channel
+{
+public:
+   typedef typename Notifier::EventPayload<EVENT>::PAYLOAD_T PAYLOAD_T;
+   
+private:
+   Notifier& _notifier;
+   
+   template<class T, void (T::*HANDLER)(const PAYLOAD_T&)>
+   static bool Thunk(Notified* observer, NOTIFIED_EVENT_TYPE_T eventType, const void* eventData)
+   {
+      (static_cast<T*>(observer)->*HANDLER)(NotifierPayloadRef<PAYLOAD_T>(eventData));
+      return false;
+   }
+   
+   template<class T, bool (T::*HANDLER)(const PAYLOAD_T&)>
+   static bool ConsumingThunk(Notified* observer, NOTIFIED_EVENT_TYPE_T eventType, const void* eventData)
+   {
+      return (static_cast<T*>(observer)->*HANDLER)(NotifierPayloadRef<PAYLOAD_T>(eventData));
+   }
+   
+   // Batch handlers get single events as a batch of one.
+   template<class T, void (T::*HANDLER)(const PAYLOAD_T*, uint32)>
+   static bool SingleToBatchThunk(Notified* observer, NOTIFIED_EVENT_TYPE_T eventType, const void* eventData)
+   {
+      (static_cast<T*>(observer)->*HANDLER)(&NotifierPayloadRef<PAYLOAD_T>(eventData), 1);
+      return false;
+   }
+   
+   template<class T, void (T::*HANDLER)(const PAYLOAD_T*, uint32)>
+   static void BatchThunk(Notified* observer, NOTIFIED_EVENT_TYPE_T eventType, const void* items, uint32 itemSize, uint32 count)
+   {
+      assert(itemSize == sizeof(PAYLOAD_T));
+      (static_cast<T*>(observer)->*HANDLER)(static_cast<const PAYLOAD_T*>(items), count);
+   }
+   
+public:
+   explicit Channel(Notifier& notifier = Notifier::Instance()) : _notifier(notifier) {}
+   
+   // Attach a member function of observer as the handler for this event.
+   // T must derive from Notified.  If observer is already attached to this
+   // event, the handler is replaced (the priority is not changed).
+   template<class T, void (T::*HANDLER)(const PAYLOAD_T&)>
+   void Attach(T* observer, int32 priority = 0)
+   {
+      _notifier.AttachSlot(observer, EVENT, &Thunk<T,HANDLER>, NULL, priority);
+   }
+   
+   // Same as above, but the handler returns true to consume the event.
+   template<class T, bool (T::*HANDLER)(const PAYLOAD_T&)>
+   void Attach(T* observer, int32 priority = 0)
+   {
+      _notifier.AttachSlot(observer, EVENT, &ConsumingThunk<T,HANDLER>, NULL, priority);
+   }
+   
+   // Attach a member function that takes an array of payloads.  It
+   // gets batches in one call and single events as a batch of one.
+   template<class T, void (T::*HANDLER)(const PAYLOAD_T*, uint32)>
+   void AttachBatch(T* observer, int32 priority = 0)
+   {
+      _notifier.AttachSlot(observer, EVENT, &SingleToBatchThunk<T,HANDLER>, &BatchThunk<T,HANDLER>, priority);
+   }
+   
+   void Detach(Notified* observer)
+   {
+      _notifier.Detach(observer, EVENT);
+   }
+   
+   // Returns true if an observer consumed the event.
+   bool Notify(const PAYLOAD_T& payload = PAYLOAD_T())
+   {
+      return _notifier.Notify(EVENT, &payload);
+   }
+   
+   void NotifyBatch(const PAYLOAD_T* payloads, uint32 count)
+   {
+      _notifier.NotifyBatch(EVENT, payloads, sizeof(PAYLOAD_T), count);
+   }
+   
+   // The payload is copied into the queue, so it has to fit.
+   bool Post(const PAYLOAD_T& payload = PAYLOAD_T())
+   {
+      assert(sizeof(PAYLOAD_T) <= POST_PAYLOAD_SIZE_MAX);
+      return _notifier.Post(EVENT, &payload, sizeof(PAYLOAD_T));
+   }
+};
+
 
 #endif /* defined(__Box2DTestBed__Notifier__) */
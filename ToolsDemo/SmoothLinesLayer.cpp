@@ -30,29 +30,126 @@
 //#define DEBUG_SMOOTH_LINES_LAYER
 
 
-/* NOTE:  For debugging, it is occasionally handy to 
- * set the leve of overdraw to 10x (or more) of the 
- * baseline value so that you can *REALLY* see it 
- * well and make sure it is lining up with the ends.
- * Changing the draw color for overdraw also helps 
- * when things look a little off (so you can see
- * the triangles.
+/* The lines are anti-aliased in the fragment shader instead of with
+ * extra "overdraw" triangles that fade out to alpha 0.  Each vertex
+ * carries its offset from the centerline and the half width of the line
+ * there, and the shader works out the coverage of each pixel from
+ * radius - |offset|.  So a segment is a single quad, pushed out a
+ * little past the edges of the line so the fade has room, and a round
+ * cap is a single quad with a circle in it.
+ *
+ * NOTE:  For debugging, set FEATHER_PIXELS to 10 or so to *REALLY* see
+ * the fade and make sure it lines up with the ends.
+ */
+const float FEATHER_PIXELS = 1.0f;
+
+/* Consecutive segments share the edge across their common point, set
+ * square to the second segment.  That hides gentle turns, but as the
+ * turn gets sharper the first segment's quad gets skewed until its
+ * outside corner leaves a notch.  So past this turn (cos of the angle,
+ * about 20 degrees) each segment keeps its own square ends and a round
+ * join is drawn over the corner.
  */
-const float OVERDRAW_LEVEL = 3.0;
+const float ROUND_JOIN_MIN_TURN_COS = 0.94f;
+
+#define kShader_SmoothLine "ShaderSmoothLine"
+
+static const GLchar* SMOOTH_LINE_VERT =
+"                                                     \n\
+attribute vec4 a_position;                            \n\
+attribute vec4 a_color;                               \n\
+attribute vec3 a_texCoord;                            \n\
+                                                      \n\
+#ifdef GL_ES                                          \n\
+varying lowp vec4 v_color;                            \n\
+varying mediump vec3 v_distance;                      \n\
+#else                                                 \n\
+varying vec4 v_color;                                 \n\
+varying vec3 v_distance;                              \n\
+#endif                                                \n\
+                                                      \n\
+void main()                                           \n\
+{                                                     \n\
+   gl_Position = CC_MVPMatrix * a_position;           \n\
+   v_color = a_color;                                 \n\
+   v_distance = a_texCoord;                           \n\
+}                                                     \n\
+";
+
+static const GLchar* SMOOTH_LINE_FRAG =
+"                                                     \n\
+#ifdef GL_ES                                          \n\
+precision mediump float;                              \n\
+varying lowp vec4 v_color;                            \n\
+#else                                                 \n\
+varying vec4 v_color;                                 \n\
+#endif                                                \n\
+varying vec3 v_distance;                              \n\
+uniform float u_feather;                              \n\
+                                                      \n\
+void main()                                           \n\
+{                                                     \n\
+   float edge = v_distance.z - length(v_distance.xy); \n\
+   float coverage = clamp(edge/u_feather + 0.5, 0.0, 1.0); \n\
+   gl_FragColor = vec4(v_color.rgb, v_color.a*coverage); \n\
+}                                                     \n\
+";
+
+// Get the stroke shader from the shader cache, building it the first
+// time.
+static CCGLProgram* GetSmoothLineShader()
+{
+   CCShaderCache* shaderCache = CCShaderCache::sharedShaderCache();
+   CCGLProgram* program = shaderCache->programForKey(kShader_SmoothLine);
+   if(program == NULL)
+   {
+      program = new CCGLProgram();
+      program->initWithVertexShaderByteArray(SMOOTH_LINE_VERT, SMOOTH_LINE_FRAG);
+      program->addAttribute(kCCAttributeNamePosition, kCCVertexAttrib_Position);
+      program->addAttribute(kCCAttributeNameColor, kCCVertexAttrib_Color);
+      program->addAttribute(kCCAttributeNameTexCoord, kCCVertexAttrib_TexCoords);
+      program->link();
+      program->updateUniforms();
+      shaderCache->addProgram(program, kShader_SmoothLine);
+      program->release();
+   }
+   return program;
+}
 
+// The batch is drawn with 16 bit indices.
+const uint32 MAX_BATCH_VERTICES = 65536;
+// Starting sizes for the batch (and the buffers it is streamed through).
+// A few hundred segments a frame is typical.
+const uint32 INITIAL_BATCH_VERTICES = 4096;
+const uint32 INITIAL_BATCH_INDICES = 3*INITIAL_BATCH_VERTICES;
 
 
-SmoothLinesLayer::SmoothLinesLayer()
+SmoothLinesLayer::SmoothLinesLayer() :
+   _featherPoints(FEATHER_PIXELS),
+   _featherLocation(-1),
+   _vertexBuffer(0),
+   _indexBuffer(0),
+   _vertexBufferCapacity(0),
+   _indexBufferCapacity(0),
+   _canvas(NULL),
+   _scissorWasEnabled(GL_FALSE)
 {
 	
 }
 
 SmoothLinesLayer::~SmoothLinesLayer()
 {
-	
+   if(_vertexBuffer != 0)
+   {
+      glDeleteBuffers(1, &_vertexBuffer);
+   }
+   if(_indexBuffer != 0)
+   {
+      glDeleteBuffers(1, &_indexBuffer);
+   }
 }
 
-void SmoothLinesLayer::AddSmoothedPoints(const vector<LineSmoother::SMOOTHED_POINT>& smoothedPoints, uint32 startIdx)
+void SmoothLinesLayer::AddSmoothedPoints(const LineSmoother::SMOOTHED_POINT_ARRAYS& smoothedPoints, uint32 startIdx)
 {
    if(startIdx > 0)
       startIdx--;
@@ -102,12 +199,65 @@ void SmoothLinesLayer::AddSmoothedPoints(const vector<LineSmoother::SMOOTHED_POI
 void SmoothLinesLayer::Reset()
 {
    _smoothedPoints.clear();
-   _renderTexture->clear(0.0, 0, 0, 0.0);
+   // Only tiles that have been drawn on exist, so this is all of it.
+   _canvas->Clear();
+}
+
+CCRect SmoothLinesLayer::GetBatchRect() const
+{
+   assert(!_vertices.empty());
+   float minX = _vertices[0].x;
+   float minY = _vertices[0].y;
+   float maxX = minX;
+   float maxY = minY;
+   for(uint32 idx = 1; idx < _vertices.size(); idx++)
+   {
+      minX = MIN(minX, _vertices[idx].x);
+      minY = MIN(minY, _vertices[idx].y);
+      maxX = MAX(maxX, _vertices[idx].x);
+      maxY = MAX(maxY, _vertices[idx].y);
+   }
+   return CCRect(minX, minY, maxX-minX, maxY-minY);
+}
+
+void SmoothLinesLayer::UpdateVisibleRect()
+{
+   // The screen corners in layer points.  The layer is only ever moved
+   // and scaled, so these two are enough.
+   CCSize scrSize = CCDirector::sharedDirector()->getWinSize();
+   CCPoint bottomLeft = convertToNodeSpace(ccp(0,0));
+   CCPoint topRight = convertToNodeSpace(ccp(scrSize.width,scrSize.height));
+   _canvas->SetVisibleRect(CCRect(bottomLeft.x, bottomLeft.y,
+                                  topRight.x-bottomLeft.x, topRight.y-bottomLeft.y));
+}
+
+void SmoothLinesLayer::ScissorToRect(const CCRect& rect)
+{
+   _scissorWasEnabled = glIsEnabled(GL_SCISSOR_TEST);
+   glGetIntegerv(GL_SCISSOR_BOX, _scissorBox);
+   // The render texture's viewport is in pixels.
+   float scale = CC_CONTENT_SCALE_FACTOR();
+   GLint x0 = (GLint)floorf(rect.getMinX()*scale);
+   GLint y0 = (GLint)floorf(rect.getMinY()*scale);
+   GLint x1 = (GLint)ceilf(rect.getMaxX()*scale);
+   GLint y1 = (GLint)ceilf(rect.getMaxY()*scale);
+   glEnable(GL_SCISSOR_TEST);
+   glScissor(x0, y0, x1-x0, y1-y0);
+}
+
+void SmoothLinesLayer::RestoreScissor()
+{
+   glScissor(_scissorBox[0], _scissorBox[1], _scissorBox[2], _scissorBox[3]);
+   if(!_scissorWasEnabled)
+   {
+      glDisable(GL_SCISSOR_TEST);
+   }
 }
 
 void SmoothLinesLayer::draw()
 {
    CCLayer::draw();
+   UpdateVisibleRect();
    DrawSmoothLines();
 }
 
@@ -127,16 +277,72 @@ SmoothLinesLayer* SmoothLinesLayer::create()
 }
 
 
+bool SmoothLinesLayer::ReserveVertices(uint32 count)
+{
+   assert(count < MAX_BATCH_VERTICES);
+   if(_vertices.size() + count <= MAX_BATCH_VERTICES)
+   {
+      return true;
+   }
+   DrawVertices();
+   return false;
+}
+
 void SmoothLinesLayer::DrawVertices()
 {
-   glVertexAttribPointer(kCCVertexAttrib_Position, 3, GL_FLOAT, GL_FALSE, sizeof(VERTEX), &_vertices[0].x);
-   glVertexAttribPointer(kCCVertexAttrib_Color, 4, GL_FLOAT, GL_FALSE, sizeof(VERTEX), &_vertices[0].color);
-   glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
-   //   glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-   glDrawArrays(GL_TRIANGLES, 0, _vertices.size());
+   if(_indices.empty())
+   {
+      _vertices.clear();
+      return;
+   }
+   
+   // Orphan the buffers (glBufferData(...) with no data) before filling
+   // them so the driver can hand out fresh storage instead of waiting
+   // for the GPU to finish with last frame's batch.  They only grow.
+   glBindBuffer(GL_ARRAY_BUFFER, _vertexBuffer);
+   _vertexBufferCapacity = MAX(_vertexBufferCapacity, _vertices.capacity());
+   glBufferData(GL_ARRAY_BUFFER, sizeof(VERTEX)*_vertexBufferCapacity, NULL, GL_STREAM_DRAW);
+   glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(VERTEX)*_vertices.size(), &_vertices[0]);
+   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _indexBuffer);
+   _indexBufferCapacity = MAX(_indexBufferCapacity, _indices.capacity());
+   glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLushort)*_indexBufferCapacity, NULL, GL_STREAM_DRAW);
+   glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, sizeof(GLushort)*_indices.size(), &_indices[0]);
+   
+   // The batch is drawn into each tile it touches, and only the part
+   // of the tile under the batch changes.
+   CCRect dirtyRect = GetBatchRect();
+   _canvas->GetTileKeys(dirtyRect, _tileKeys);
+   for(uint32 idx = 0; idx < _tileKeys.size(); idx++)
+   {
+      CCRect tileRect = _canvas->GetTileRect(_tileKeys[idx]);
+      float minX = MAX(dirtyRect.getMinX(), tileRect.getMinX());
+      float minY = MAX(dirtyRect.getMinY(), tileRect.getMinY());
+      float maxX = MIN(dirtyRect.getMaxX(), tileRect.getMaxX());
+      float maxY = MIN(dirtyRect.getMaxY(), tileRect.getMaxY());
+      
+      _canvas->BeginTile(_tileKeys[idx]);
+      ScissorToRect(CCRect(minX-tileRect.getMinX(), minY-tileRect.getMinY(), maxX-minX, maxY-minY));
+      CC_NODE_DRAW_SETUP();
+      getShaderProgram()->setUniformLocationWith1f(_featherLocation, _featherPoints);
+      ccGLEnableVertexAttribs(kCCVertexAttribFlag_PosColorTex);
+      glVertexAttribPointer(kCCVertexAttrib_Position, 2, GL_FLOAT, GL_FALSE, sizeof(VERTEX), (GLvoid*)offsetof(VERTEX, x));
+      glVertexAttribPointer(kCCVertexAttrib_Color, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(VERTEX), (GLvoid*)offsetof(VERTEX, color));
+      glVertexAttribPointer(kCCVertexAttrib_TexCoords, 3, GL_FLOAT, GL_FALSE, sizeof(VERTEX), (GLvoid*)offsetof(VERTEX, distanceX));
+      glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+      //   glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+      glDrawElements(GL_TRIANGLES, _indices.size(), GL_UNSIGNED_SHORT, 0);
+      CC_INCREMENT_GL_DRAWS(1);
+      RestoreScissor();
+      _canvas->EndTile();
+   }
+   
+   // The rest of cocos2d draws from client memory.
+   glBindBuffer(GL_ARRAY_BUFFER, 0);
+   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
-   // Clear out, we are done with these.
+   // Clear out, we are done with these.  The capacity is kept.
    _vertices.clear();
+   _indices.clear();
 }
 
 
@@ -147,50 +353,59 @@ void SmoothLinesLayer::DrawSmoothLines()
    if(_smoothedPoints.size() < 3)
       return;
    
-   // All drawing to the texture happens between the begin/end calls.
-   _renderTexture->begin();
+   _vertexColor = ccc4BFromccc4F(_drawColor);
    
    // We can have "anything" in the list of smoothed points, so we have
    // to handle it that way.
+   uint32 joinIndex = NO_JOIN;
    for(int idx = 2; idx < _smoothedPoints.size(); idx++)
    {
       const SMOOTHED_POINT& p0 = _smoothedPoints[idx-2];
       const SMOOTHED_POINT& p1 = _smoothedPoints[idx-1];
       const SMOOTHED_POINT& p2 = _smoothedPoints[idx-0];
       
+      if(p0.position == LineSmoother::LP_END || p1.position == LineSmoother::LP_END)
+      {  // Either between two lines, or the last span of a line, which
+         // was drawn along with its END point.
+         joinIndex = NO_JOIN;
+         continue;
+      }
       if(p0.position == LineSmoother::LP_BEGIN)
-      {  // First point of a new line.
+      {  // First point of a new line.  It does not share vertices with
+         // whatever came before it.
          DrawHalfCircle(p0,p1,true, p1.widthPixels);
+         joinIndex = NO_JOIN;
       }
-      DrawSmoothedLineSegment(p0, p1, p2);
+      joinIndex = DrawSmoothedLineSegment(p0, p1, p2, joinIndex);
       if(p2.position == LineSmoother::LP_END)
-      {
-         DrawHalfCircle(p1,p2,false, p1.widthPixels);
+      {  // The line runs all the way to the END point, and the cap goes
+         // around it.  There is no point after it, so the last span is
+         // ended square (as if the line went straight on).
+         if(ccpDistanceSQ(p1.point, p2.point) > 0)
+         {
+            SMOOTHED_POINT beyond = p2;
+            beyond.point = ccpAdd(p2.point, ccpSub(p2.point, p1.point));
+            DrawSmoothedLineSegment(p1, p2, beyond, joinIndex);
+            DrawHalfCircle(p2,p1,true, p2.widthPixels);
+         }
+         else
+         {  // p1 is already on the END point.
+            DrawHalfCircle(p2,p0,true, p2.widthPixels);
+         }
+         joinIndex = NO_JOIN;
       }
    }
    
    // Do th actual drawing.
    DrawVertices();
 
-   // Store off the last point.
-   SMOOTHED_POINT lastPoint = _smoothedPoints[_smoothedPoints.size()-1];
    // We're done, clear out the memory.
    _smoothedPoints.clear();
-   
-   // End drawing to the texture.
-   _renderTexture->end();
-   
 }
 
 
-void SmoothLinesLayer::DrawHalfCircle(const SMOOTHED_POINT& p0, const SMOOTHED_POINT& p1, bool flip, float widthPixels)
+bool SmoothLinesLayer::DrawHalfCircle(const SMOOTHED_POINT& p0, const SMOOTHED_POINT& p1, bool flip, float widthPixels)
 {
-   ccColor4F drawColorClear =  ccc4f(_drawColor.r, _drawColor.g, _drawColor.b, 0.0f);
-   ccColor4F drawColor = _drawColor;
-   const int slices = 16;
-   float dtheta = M_PI/slices;
-   VERTEX vertex;
-   
    CCPoint p0p = p0.point;
    CCPoint p1p = p1.point;
    if(flip)
@@ -199,107 +414,92 @@ void SmoothLinesLayer::DrawHalfCircle(const SMOOTHED_POINT& p0, const SMOOTHED_P
       p1p = ccpAdd(p0p,ccpMult(ccpSub(p0p, p1p), 2));
    }
    
-   CCPoint p01np = ccpPerp(ccpNormalize(ccpSub(p0p, p1p)));
-   float thetaStart = atan2f(p01np.y, p01np.x);
+   // One quad over the half of the circle (around p0) that faces p1p.
+   // The shader cuts the circle out of it.
+   CCPoint along = ccpNormalize(ccpSub(p1p, p0p));
+   CCPoint across = ccpPerp(along);
+   float radius = widthPixels/2;
+   float extent = radius + _featherPoints;
+   CCPoint side = ccpMult(across, extent);
+   CCPoint out = ccpMult(along, extent);
    
-   float cosCurr = cosf(thetaStart);
-   float sinCurr = sinf(thetaStart);
-   
-   for(int idx = 1; idx < slices; idx++)
-   {
-      float theta = thetaStart + dtheta*idx;
-      
-      // Try to only do this computation once.  The vector created from ccp(cos(theta),sin(theta))
-      // is used again the next time through as the previous slice side.
-      float cosNext = cosf(theta+dtheta);
-      float sinNext = sinf(theta+dtheta);
-      
-      CCPoint A = ccpAdd(p0p, ccpMult(ccp(cosCurr,sinCurr),widthPixels/2));
-      CCPoint B = ccpAdd(p0p, ccpMult(ccp(cosNext,sinNext),widthPixels/2));
-      CCPoint C = ccpAdd(p0p, ccpMult(ccp(cosCurr,sinCurr),widthPixels/2+OVERDRAW_LEVEL));
-      CCPoint D = ccpAdd(p0p, ccpMult(ccp(cosNext,sinNext),widthPixels/2+OVERDRAW_LEVEL));
-      
-      cosCurr = cosNext;
-      sinCurr = sinNext;
-      
-      // Main Triangle (1)
-      vertex.x = p0p.x;vertex.y = p0p.y; vertex.z = 1.0; vertex.color = drawColor; _vertices.push_back(vertex);
-      vertex.x = A.x;vertex.y = A.y; vertex.z = 1.0; vertex.color = drawColor; _vertices.push_back(vertex);
-      vertex.x = B.x;vertex.y = B.y; vertex.z = 1.0; vertex.color = drawColor; _vertices.push_back(vertex);
-      
-      // Overdraw triangles (2)
-      // ACD
-      vertex.x = A.x;vertex.y = A.y; vertex.z = 1.0; vertex.color = _drawColor; _vertices.push_back(vertex);
-      vertex.x = C.x;vertex.y = C.y; vertex.z = 1.0; vertex.color = drawColorClear; _vertices.push_back(vertex);
-      vertex.x = D.x;vertex.y = D.y; vertex.z = 1.0; vertex.color = drawColorClear; _vertices.push_back(vertex);
-      // ADB
-      vertex.x = A.x;vertex.y = A.y; vertex.z = 1.0; vertex.color = _drawColor; _vertices.push_back(vertex);
-      vertex.x = D.x;vertex.y = D.y; vertex.z = 1.0; vertex.color = drawColorClear; _vertices.push_back(vertex);
-      vertex.x = B.x;vertex.y = B.y; vertex.z = 1.0; vertex.color = _drawColor; _vertices.push_back(vertex);
-      
-   }
+   bool drewBatch = !ReserveVertices(4);
+   GLushort A = AddVertex(ccpAdd(p0p, side), extent, 0, radius);
+   GLushort C = AddVertex(ccpSub(p0p, side), -extent, 0, radius);
+   GLushort B = AddVertex(ccpAdd(ccpAdd(p0p, side), out), extent, extent, radius);
+   GLushort D = AddVertex(ccpAdd(ccpSub(p0p, side), out), -extent, extent, radius);
+   AddTriangle(A, B, C);
+   AddTriangle(C, B, D);
+   return drewBatch;
 }
 
 
-void SmoothLinesLayer::DrawSmoothedLineSegment(const SMOOTHED_POINT& p0, const SMOOTHED_POINT& p1, const SMOOTHED_POINT& p2)
+bool SmoothLinesLayer::DrawRoundJoin(const CCPoint& center, float radius)
 {
-   VERTEX vertex;
-   ccColor4F drawColorClear =  ccc4f(_drawColor.r, _drawColor.g, _drawColor.b, 0.0f);
+   // One quad over the whole circle.
+   float extent = radius + _featherPoints;
    
+   bool drewBatch = !ReserveVertices(4);
+   GLushort A = AddVertex(ccpAdd(center, ccp(-extent,-extent)), -extent, -extent, radius);
+   GLushort B = AddVertex(ccpAdd(center, ccp(extent,-extent)), extent, -extent, radius);
+   GLushort C = AddVertex(ccpAdd(center, ccp(-extent,extent)), -extent, extent, radius);
+   GLushort D = AddVertex(ccpAdd(center, ccp(extent,extent)), extent, extent, radius);
+   AddTriangle(A, B, C);
+   AddTriangle(C, B, D);
+   return drewBatch;
+}
+
+
+uint32 SmoothLinesLayer::DrawSmoothedLineSegment(const SMOOTHED_POINT& p0, const SMOOTHED_POINT& p1, const SMOOTHED_POINT& p2,
+                                                 uint32 joinIndex)
+{
    CCPoint p0p = p0.point;
    CCPoint p1p = p1.point;
    CCPoint p2p = p2.point;
-   float p0width = p0.widthPixels;
-   float p1width = p1.widthPixels;
+   float p0radius = p0.widthPixels/2;
+   float p1radius = p1.widthPixels/2;
    
-
    CCPoint p01n = ccpNormalize(ccpSub(p1p, p0p));
-   CCPoint p12n = ccpNormalize(ccpSub(p2p, p1p));
    CCPoint p01np = ccpPerp(p01n);
+   CCPoint p12n = ccpNormalize(ccpSub(p2p, p1p));
    CCPoint p12np = ccpPerp(p12n);
+   bool sharpTurn = ccpDot(p01n, p12n) < ROUND_JOIN_MIN_TURN_COS;
+   if(sharpTurn)
+   {  // Square this end off too; the join covers the corner.
+      p12np = p01np;
+   }
    
-   CCPoint A = ccpAdd(p0p, ccpMult(p01np, p0width/2));
-   CCPoint B = ccpAdd(p1p, ccpMult(p12np, p1width/2));
-   CCPoint C = ccpSub(p0p, ccpMult(p01np, p0width/2));
-   CCPoint D = ccpSub(p1p, ccpMult(p12np, p1width/2));
-   
-   CCPoint E = ccpAdd(p0p, ccpMult(p01np, OVERDRAW_LEVEL + p0width/2));
-   CCPoint F = ccpAdd(p1p, ccpMult(p12np, OVERDRAW_LEVEL + p1width/2));
-   CCPoint G = ccpSub(p0p, ccpMult(p01np, OVERDRAW_LEVEL + p0width/2));
-   CCPoint H = ccpSub(p1p, ccpMult(p12np, OVERDRAW_LEVEL + p1width/2));
-
-   // Do the main line segment triangles (2)
-   // ABC
-   vertex.x = A.x;vertex.y = A.y; vertex.z = 1.0; vertex.color = _drawColor; _vertices.push_back(vertex);
-   vertex.x = B.x;vertex.y = B.y; vertex.z = 1.0; vertex.color = _drawColor; _vertices.push_back(vertex);
-   vertex.x = C.x;vertex.y = C.y; vertex.z = 1.0; vertex.color = _drawColor; _vertices.push_back(vertex);
-   
-   // CBD
-   vertex.x = C.x;vertex.y = C.y; vertex.z = 1.0; vertex.color = _drawColor; _vertices.push_back(vertex);
-   vertex.x = B.x;vertex.y = B.y; vertex.z = 1.0; vertex.color = _drawColor; _vertices.push_back(vertex);
-   vertex.x = D.x;vertex.y = D.y; vertex.z = 1.0; vertex.color = _drawColor; _vertices.push_back(vertex);
-   
-   // Do the overdraw triangles (4)
-   // Note that the vertices on the external edges have clear color (alpha = 0.0f).
-   // AEF
-   vertex.x = A.x;vertex.y = A.y; vertex.z = 1.0; vertex.color = _drawColor; _vertices.push_back(vertex);
-   vertex.x = E.x;vertex.y = E.y; vertex.z = 1.0; vertex.color = drawColorClear; _vertices.push_back(vertex);
-   vertex.x = F.x;vertex.y = F.y; vertex.z = 1.0; vertex.color = drawColorClear; _vertices.push_back(vertex);
-   
-   // AFB
-   vertex.x = A.x;vertex.y = A.y; vertex.z = 1.0; vertex.color = _drawColor; _vertices.push_back(vertex);
-   vertex.x = F.x;vertex.y = F.y; vertex.z = 1.0; vertex.color = drawColorClear; _vertices.push_back(vertex);
-   vertex.x = B.x;vertex.y = B.y; vertex.z = 1.0; vertex.color = _drawColor; _vertices.push_back(vertex);
-
-   // CDG
-   vertex.x = C.x;vertex.y = C.y; vertex.z = 1.0; vertex.color = _drawColor; _vertices.push_back(vertex);
-   vertex.x = D.x;vertex.y = D.y; vertex.z = 1.0; vertex.color = _drawColor; _vertices.push_back(vertex);
-   vertex.x = G.x;vertex.y = G.y; vertex.z = 1.0; vertex.color = drawColorClear; _vertices.push_back(vertex);
+   // The vertices at p0 (A and C) are the same ones the previous
+   // segment put at its p1, so reuse them if we can.
+   GLushort A, C;
+   if(joinIndex != NO_JOIN && ReserveVertices(2))
+   {
+      A = joinIndex;
+      C = joinIndex+1;
+   }
+   else
+   {
+      ReserveVertices(4);
+      float p0extent = p0radius + _featherPoints;
+      A = AddVertex(ccpAdd(p0p, ccpMult(p01np, p0extent)), p0extent, 0, p0radius);
+      C = AddVertex(ccpSub(p0p, ccpMult(p01np, p0extent)), -p0extent, 0, p0radius);
+   }
+   // The quad reaches past the edges of the line by the feather width,
+   // so the fade happens inside it.
+   float p1extent = p1radius + _featherPoints;
+   GLushort B = AddVertex(ccpAdd(p1p, ccpMult(p12np, p1extent)), p1extent, 0, p1radius);
+   GLushort D = AddVertex(ccpSub(p1p, ccpMult(p12np, p1extent)), -p1extent, 0, p1radius);
+
+   AddTriangle(A, B, C);
+   AddTriangle(C, B, D);
    
-   // GDH
-   vertex.x = G.x;vertex.y = G.y; vertex.z = 1.0; vertex.color = drawColorClear; _vertices.push_back(vertex);
-   vertex.x = D.x;vertex.y = D.y; vertex.z = 1.0; vertex.color = _drawColor; _vertices.push_back(vertex);
-   vertex.x = H.x;vertex.y = H.y; vertex.z = 1.0; vertex.color = drawColorClear; _vertices.push_back(vertex);
+   if(sharpTurn)
+   {  // The next segment starts fresh, so it does not matter if this
+      // had to draw the batch.
+      DrawRoundJoin(p1p, p1radius);
+      return NO_JOIN;
+   }
+   return B;
 }
 
 
@@ -308,18 +508,26 @@ bool SmoothLinesLayer::init()
    if(!CCLayer::init())
       return false;
    
-   CCSize scrSize = CCDirector::sharedDirector()->getWinSize();
-   
-   _renderTexture = CCRenderTexture::create(scrSize.width, scrSize.height, kCCTexture2DPixelFormat_RGBA8888);
-   _renderTexture->setPosition(ccp(scrSize.width/2,scrSize.height/2));
-   addChild(_renderTexture);
-   Reset();
+   // Pan and zoom are the layer's position and scale, so keep the
+   // origin of the canvas at the layer's position.
+   setAnchorPoint(ccp(0,0));
+   _canvas = TiledCanvas::create();
+   assert(_canvas != NULL);
+   addChild(_canvas);
    
    _smoothedPoints.reserve(500);
+   _vertices.reserve(INITIAL_BATCH_VERTICES);
+   _indices.reserve(INITIAL_BATCH_INDICES);
+   glGenBuffers(1, &_vertexBuffer);
+   glGenBuffers(1, &_indexBuffer);
 
-   // Set this as the shader program for this layer.  This is one of the default shaders
-   // in cocos2d-x (and cocos2d). 
-   setShaderProgram(CCShaderCache::sharedShaderCache()->programForKey(kCCShader_PositionColor));
+   // The stroke shader does the anti-aliasing.  It lives in the shader
+   // cache next to the default cocos2d-x shaders.
+   setShaderProgram(GetSmoothLineShader());
+   _featherLocation = getShaderProgram()->getUniformLocationForName("u_feather");
+   // The tiles are drawn at full resolution, so fade over
+   // FEATHER_PIXELS device pixels.
+   _featherPoints = FEATHER_PIXELS/CC_CONTENT_SCALE_FACTOR();
    
    return true;
 }
\ No newline at end of file
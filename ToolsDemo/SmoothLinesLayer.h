@@ -30,32 +30,104 @@
 #include "CommonSTL.h"
 #include "CommonProject.h"
 #include "LineSmoother.h"
+#include "TiledCanvas.h"
 
 class SmoothLinesLayer : public CCLayer
 {
 private:
    typedef LineSmoother::SMOOTHED_POINT SMOOTHED_POINT;
+   // Packed vertex for the stroke shader.  distanceX/Y is where the
+   // vertex is relative to the nearest point on the centerline (or the
+   // center of a cap), and radius is the half width of the line there.
+   // The fragment shader turns radius - |distance| into coverage.
    typedef struct {
-      float x;
-      float y;
-      float z;
-      ccColor4F color;
+      GLfloat x;
+      GLfloat y;
+      ccColor4B color;
+      GLfloat distanceX;
+      GLfloat distanceY;
+      GLfloat radius;
    } VERTEX;
    
+   // Passed to DrawSmoothedLineSegment(...) when there is no previous
+   // segment to share vertices with.
+   enum
+   {
+      NO_JOIN = 0xFFFFFFFF
+   };
    
    ccColor4F _drawColor;
+   // The draw color as bytes, for the batch being built.
+   ccColor4B _vertexColor;
+   // How far (in points) the edge fades out over, and the location of
+   // the stroke shader's uniform for it.
+   float _featherPoints;
+   GLint _featherLocation;
+   // The batch of triangles being built.  Segments share the vertices on
+   // their common edge, so the triangles are drawn indexed.
    vector<VERTEX> _vertices;
+   vector<GLushort> _indices;
+   // Vertex and index buffers the batch is streamed through, and the
+   // sizes (in elements) they were last allocated with.
+   GLuint _vertexBuffer;
+   GLuint _indexBuffer;
+   uint32 _vertexBufferCapacity;
+   uint32 _indexBufferCapacity;
    vector<SMOOTHED_POINT> _smoothedPoints;
-   CCRenderTexture* _renderTexture;
+   // The lines are drawn on this, in layer points.  Moving or scaling
+   // the layer pans and zooms it.
+   TiledCanvas* _canvas;
+   // The tiles the batch being drawn touches.
+   vector<TiledCanvas::TILE_KEY_T> _tileKeys;
       
    bool init();
    
    void DrawSmoothLines();
-   void DrawHalfCircle(const SMOOTHED_POINT& p0, const SMOOTHED_POINT& p1, bool flip, float width);
-   void DrawSmoothedLineSegment(const SMOOTHED_POINT& p0, const SMOOTHED_POINT& p1, const SMOOTHED_POINT& p2);
+   // These return true if they had to draw the batch first to make
+   // room (so a joinIndex from before the call is no good).
+   bool DrawHalfCircle(const SMOOTHED_POINT& p0, const SMOOTHED_POINT& p1, bool flip, float width);
+   bool DrawRoundJoin(const CCPoint& center, float radius);
+   // Returns the index of the two vertices at p1, which the next
+   // segment can share by passing them as joinIndex (or NO_JOIN if the
+   // line turns too sharply at p1 for that, in which case it draws a
+   // round join there instead).
+   uint32 DrawSmoothedLineSegment(const SMOOTHED_POINT& p0, const SMOOTHED_POINT& p1, const SMOOTHED_POINT& p2,
+                                  uint32 joinIndex);
    void DrawVertices();
+   // The bounding box of the vertices in the batch.
+   CCRect GetBatchRect() const;
+   // Tell the canvas which part of it is on the screen.
+   void UpdateVisibleRect();
+   // Limit drawing to a render texture to rect (in its points, call
+   // between its begin() and end()), saving the scissor state for
+   // RestoreScissor().
+   void ScissorToRect(const CCRect& rect);
+   void RestoreScissor();
+   GLboolean _scissorWasEnabled;
+   GLint _scissorBox[4];
    
-   
+   // Make room for count more vertices, drawing the batch first if the
+   // 16 bit indices would run out.  Returns false if it had to draw (so
+   // the vertices already in the batch are gone).
+   bool ReserveVertices(uint32 count);
+   GLushort AddVertex(const CCPoint& pt, float distanceX, float distanceY, float radius)
+   {
+      VERTEX vertex;
+      vertex.x = pt.x;
+      vertex.y = pt.y;
+      vertex.color = _vertexColor;
+      vertex.distanceX = distanceX;
+      vertex.distanceY = distanceY;
+      vertex.radius = radius;
+      _vertices.push_back(vertex);
+      return _vertices.size()-1;
+   }
+   void AddTriangle(GLushort i0, GLushort i1, GLushort i2)
+   {
+      _indices.push_back(i0);
+      _indices.push_back(i1);
+      _indices.push_back(i2);
+   }
    
    SmoothLinesLayer();
    ~SmoothLinesLayer();
@@ -63,9 +135,10 @@ private:
 public:
    
    void Reset();
-   void AddSmoothedPoints(const vector<LineSmoother::SMOOTHED_POINT>& smoothedPoints, uint32 startIdx);
+   void AddSmoothedPoints(const LineSmoother::SMOOTHED_POINT_ARRAYS& smoothedPoints, uint32 startIdx);
    void SetDrawColor(const ccColor4F& drawColor) { _drawColor = drawColor; }
    const ccColor4F& GetDrawColor() { return _drawColor; }
+   TiledCanvas* GetCanvas() { return _canvas; }
    
    virtual void draw();
    static SmoothLinesLayer* create();
@@ -0,0 +1,256 @@
+/********************************************************************
+ * File   : SplineKernels.cpp
+ * Project: ToolsDemo
+ *
+ ********************************************************************
+ * Created on 10/18/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+#include "SplineKernels.h"
+
+#if !defined(SPLINE_KERNELS_SCALAR)
+#if defined(__SSE2__)
+#define SPLINE_KERNELS_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define SPLINE_KERNELS_NEON
+#include <arm_neon.h>
+#endif
+#endif
+
+void SplineKernels::EvaluateScalar(const CUBIC_T& cubicX, const CUBIC_T& cubicY, const CUBIC_T& cubicWidth,
+                                   float dt, uint32 count,
+                                   float* outX, float* outY, float* outWidth)
+{
+   for(uint32 idx = 0; idx < count; idx++)
+   {
+      float t = idx*dt;
+      outX[idx] = EvaluateAt(cubicX, t);
+      outY[idx] = EvaluateAt(cubicY, t);
+      outWidth[idx] = EvaluateAt(cubicWidth, t);
+   }
+}
+
+// Step one channel of a cubic along t = 0, dt, 2*dt...
+class ForwardDifference
+{
+private:
+   double _value;
+   double _d1;
+   double _d2;
+   double _d3;
+public:
+   ForwardDifference(const SplineKernels::CUBIC_T& cubic, double dt)
+   {
+      double dtSq = dt*dt;
+      double dtCube = dtSq*dt;
+      _value = cubic.c0;
+      _d1 = cubic.c1*dt + cubic.c2*dtSq + cubic.c3*dtCube;
+      _d2 = 2*cubic.c2*dtSq + 6*cubic.c3*dtCube;
+      _d3 = 6*cubic.c3*dtCube;
+   }
+   
+   float Next()
+   {
+      float result = (float)_value;
+      _value += _d1;
+      _d1 += _d2;
+      _d2 += _d3;
+      return result;
+   }
+};
+
+void SplineKernels::EvaluateForwardDifference(const CUBIC_T& cubicX, const CUBIC_T& cubicY, const CUBIC_T& cubicWidth,
+                                              float dt, uint32 count,
+                                              float* outX, float* outY, float* outWidth)
+{
+   ForwardDifference x(cubicX, dt);
+   ForwardDifference y(cubicY, dt);
+   ForwardDifference width(cubicWidth, dt);
+   for(uint32 idx = 0; idx < count; idx++)
+   {
+      outX[idx] = x.Next();
+      outY[idx] = y.Next();
+      outWidth[idx] = width.Next();
+   }
+}
+
+uint32 SplineKernels::FlatnessSteps(const CUBIC_T& cubicX, const CUBIC_T& cubicY, float tolerancePixels)
+{
+   assert(tolerancePixels > 0);
+   // |f''| at each end of the segment.
+   float ddx0 = 2*cubicX.c2;
+   float ddy0 = 2*cubicY.c2;
+   float ddx1 = ddx0 + 6*cubicX.c3;
+   float ddy1 = ddy0 + 6*cubicY.c3;
+   float maxSecond = sqrtf(std::max(ddx0*ddx0 + ddy0*ddy0, ddx1*ddx1 + ddy1*ddy1));
+   float steps = ceilf(sqrtf(maxSecond/(8*tolerancePixels)));
+   // Guard against NaN/infinite input as well as the flat case.
+   if(!(steps >= 1.0f))
+   {
+      return 1;
+   }
+   if(steps > 65536.0f)
+   {
+      return 65536;
+   }
+   return (uint32)steps;
+}
+
+#if defined(SPLINE_KERNELS_SSE2)
+
+const char* SplineKernels::GetKernelName()
+{
+   return "SSE2";
+}
+
+typedef struct
+{
+   __m128 c0;
+   __m128 c1;
+   __m128 c2;
+   __m128 c3;
+} CUBIC_SSE2_T;
+
+static inline CUBIC_SSE2_T Broadcast(const SplineKernels::CUBIC_T& cubic)
+{
+   CUBIC_SSE2_T result;
+   result.c0 = _mm_set1_ps(cubic.c0);
+   result.c1 = _mm_set1_ps(cubic.c1);
+   result.c2 = _mm_set1_ps(cubic.c2);
+   result.c3 = _mm_set1_ps(cubic.c3);
+   return result;
+}
+
+static inline __m128 Horner(const CUBIC_SSE2_T& cubic, __m128 t)
+{
+   __m128 result = _mm_add_ps(_mm_mul_ps(cubic.c3, t), cubic.c2);
+   result = _mm_add_ps(_mm_mul_ps(result, t), cubic.c1);
+   return _mm_add_ps(_mm_mul_ps(result, t), cubic.c0);
+}
+
+void SplineKernels::Evaluate(const CUBIC_T& cubicX, const CUBIC_T& cubicY, const CUBIC_T& cubicWidth,
+                             float dt, uint32 count,
+                             float* outX, float* outY, float* outWidth)
+{
+   const CUBIC_SSE2_T vx = Broadcast(cubicX);
+   const CUBIC_SSE2_T vy = Broadcast(cubicY);
+   const CUBIC_SSE2_T vw = Broadcast(cubicWidth);
+   const __m128 vdt = _mm_set1_ps(dt);
+   const __m128 step = _mm_set1_ps(4.0f);
+   // The index of each lane as a float.  t is index*dt (rather than
+   // adding dt each time) so the lanes match the scalar loop.
+   __m128 index = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+   uint32 idx = 0;
+   for(; idx + 4 <= count; idx += 4)
+   {
+      __m128 t = _mm_mul_ps(index, vdt);
+      _mm_storeu_ps(outX + idx, Horner(vx, t));
+      _mm_storeu_ps(outY + idx, Horner(vy, t));
+      _mm_storeu_ps(outWidth + idx, Horner(vw, t));
+      index = _mm_add_ps(index, step);
+   }
+   for(; idx < count; idx++)
+   {
+      float t = idx*dt;
+      outX[idx] = EvaluateAt(cubicX, t);
+      outY[idx] = EvaluateAt(cubicY, t);
+      outWidth[idx] = EvaluateAt(cubicWidth, t);
+   }
+}
+
+#elif defined(SPLINE_KERNELS_NEON)
+
+const char* SplineKernels::GetKernelName()
+{
+   return "NEON";
+}
+
+typedef struct
+{
+   float32x4_t c0;
+   float32x4_t c1;
+   float32x4_t c2;
+   float32x4_t c3;
+} CUBIC_NEON_T;
+
+static inline CUBIC_NEON_T Broadcast(const SplineKernels::CUBIC_T& cubic)
+{
+   CUBIC_NEON_T result;
+   result.c0 = vdupq_n_f32(cubic.c0);
+   result.c1 = vdupq_n_f32(cubic.c1);
+   result.c2 = vdupq_n_f32(cubic.c2);
+   result.c3 = vdupq_n_f32(cubic.c3);
+   return result;
+}
+
+// A separate multiply and add (not vfmaq) to match the SSE2 path.
+static inline float32x4_t Horner(const CUBIC_NEON_T& cubic, float32x4_t t)
+{
+   float32x4_t result = vaddq_f32(vmulq_f32(cubic.c3, t), cubic.c2);
+   result = vaddq_f32(vmulq_f32(result, t), cubic.c1);
+   return vaddq_f32(vmulq_f32(result, t), cubic.c0);
+}
+
+void SplineKernels::Evaluate(const CUBIC_T& cubicX, const CUBIC_T& cubicY, const CUBIC_T& cubicWidth,
+                             float dt, uint32 count,
+                             float* outX, float* outY, float* outWidth)
+{
+   const CUBIC_NEON_T vx = Broadcast(cubicX);
+   const CUBIC_NEON_T vy = Broadcast(cubicY);
+   const CUBIC_NEON_T vw = Broadcast(cubicWidth);
+   const float32x4_t vdt = vdupq_n_f32(dt);
+   const float32x4_t step = vdupq_n_f32(4.0f);
+   static const float lanes[4] = { 0.0f, 1.0f, 2.0f, 3.0f };
+   float32x4_t index = vld1q_f32(lanes);
+   uint32 idx = 0;
+   for(; idx + 4 <= count; idx += 4)
+   {
+      float32x4_t t = vmulq_f32(index, vdt);
+      vst1q_f32(outX + idx, Horner(vx, t));
+      vst1q_f32(outY + idx, Horner(vy, t));
+      vst1q_f32(outWidth + idx, Horner(vw, t));
+      index = vaddq_f32(index, step);
+   }
+   for(; idx < count; idx++)
+   {
+      float t = idx*dt;
+      outX[idx] = EvaluateAt(cubicX, t);
+      outY[idx] = EvaluateAt(cubicY, t);
+      outWidth[idx] = EvaluateAt(cubicWidth, t);
+   }
+}
+
+#else
+
+const char* SplineKernels::GetKernelName()
+{
+   return "Scalar";
+}
+
+void SplineKernels::Evaluate(const CUBIC_T& cubicX, const CUBIC_T& cubicY, const CUBIC_T& cubicWidth,
+                             float dt, uint32 count,
+                             float* outX, float* outY, float* outWidth)
+{
+   EvaluateScalar(cubicX, cubicY, cubicWidth, dt, count, outX, outY, outWidth);
+}
+
+#endif
@@ -0,0 +1,149 @@
+/********************************************************************
+ * File   : SplineKernels.h
+ * Project: ToolsDemo
+ *
+ ********************************************************************
+ * Created on 10/18/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+#ifndef __ToolsDemo__SplineKernels__
+#define __ToolsDemo__SplineKernels__
+
+#include "CommonSTL.h"
+#include <cmath>
+
+/* Batch evaluation of the cubic segments used by the line smoothers.
+ *
+ * Every segment the smoothers draw (Catmull-Rom, Hermite/Cardinal and
+ * the linear width ramp) is a cubic in t along each axis, so each one
+ * is converted to power form once:
+ *
+ *    f(t) = c0 + c1*t + c2*t^2 + c3*t^3
+ *
+ * and Evaluate(...) fills the x, y and width arrays of a segment with
+ * f(idx*dt) for idx = 0..count-1.  The loop runs 4 values of t per
+ * iteration (12 outputs) with SSE2 (x86) or NEON (ARM) and falls back
+ * to plain C++ on anything else.  The SIMD and scalar paths do the same
+ * float operations in the same order, so they agree to within float
+ * rounding (exactly, unless the compiler fuses the scalar multiply-adds).
+ *
+ * Define SPLINE_KERNELS_SCALAR to force the scalar path.
+ *
+ * This file does not depend on cocos2d so it can be benchmarked on its
+ * own (see CppUnitTest/SplineKernelsBenchmark.cpp).
+ */
+class SplineKernels
+{
+public:
+   typedef struct
+   {
+      float c0;
+      float c1;
+      float c2;
+      float c3;
+   } CUBIC_T;
+   
+   // Uniform Catmull-Rom between p1 and p2 (p0 and p3 are the
+   // neighbors on either side).
+   static CUBIC_T CatmullRomCubic(float p0, float p1, float p2, float p3)
+   {
+      CUBIC_T cubic;
+      cubic.c0 = p1;
+      cubic.c1 = 0.5f*(p2 - p0);
+      cubic.c2 = 0.5f*(2*p0 - 5*p1 + 4*p2 - p3);
+      cubic.c3 = 0.5f*(3*(p1 - p2) + p3 - p0);
+      return cubic;
+   }
+   
+   // Non-uniform Catmull-Rom between p1 and p2, where d01, d12 and d23
+   // are the knot intervals between the points (|p1-p0|^alpha etc.).
+   // All intervals equal gives the uniform curve above.  The tangents
+   // at p1 and p2 are worked out for the knot spacing, then scaled by
+   // d12 so the segment still runs over t = [0,1].
+   static CUBIC_T CatmullRomCubic(float p0, float p1, float p2, float p3,
+                                  float d01, float d12, float d23)
+   {
+      float m1 = (p1 - p0)/d01 - (p2 - p0)/(d01 + d12) + (p2 - p1)/d12;
+      float m2 = (p2 - p1)/d12 - (p3 - p1)/(d12 + d23) + (p3 - p2)/d23;
+      return HermiteCubic(p1, p2, m1*d12, m2*d12);
+   }
+   
+   // Hermite between p0 and p1 with tangents m0 and m1.
+   static CUBIC_T HermiteCubic(float p0, float p1, float m0, float m1)
+   {
+      CUBIC_T cubic;
+      cubic.c0 = p0;
+      cubic.c1 = m0;
+      cubic.c2 = 3*(p1 - p0) - 2*m0 - m1;
+      cubic.c3 = 2*(p0 - p1) + m0 + m1;
+      return cubic;
+   }
+   
+   // Straight line from start to end (same as MathUtilities::LinearTween).
+   static CUBIC_T LinearCubic(float start, float end)
+   {
+      CUBIC_T cubic;
+      cubic.c0 = start;
+      cubic.c1 = end - start;
+      cubic.c2 = 0;
+      cubic.c3 = 0;
+      return cubic;
+   }
+   
+   static float EvaluateAt(const CUBIC_T& cubic, float t)
+   {
+      return ((cubic.c3*t + cubic.c2)*t + cubic.c1)*t + cubic.c0;
+   }
+   
+   // Write cubicX(idx*dt) into outX[idx], and the same for y and width,
+   // for idx = 0..count-1, using the best kernel available for this build.
+   static void Evaluate(const CUBIC_T& cubicX, const CUBIC_T& cubicY, const CUBIC_T& cubicWidth,
+                        float dt, uint32 count,
+                        float* outX, float* outY, float* outWidth);
+   
+   // The plain C++ version of Evaluate(...).  Always available.
+   static void EvaluateScalar(const CUBIC_T& cubicX, const CUBIC_T& cubicY, const CUBIC_T& cubicWidth,
+                              float dt, uint32 count,
+                              float* outX, float* outY, float* outWidth);
+   
+   // Same output as Evaluate(...), but by forward differencing: after a
+   // little setup, each point costs three adds per channel instead of a
+   // full cubic.  The running sums are kept in double so the error stays
+   // well under a pixel even for segments with thousands of steps.
+   static void EvaluateForwardDifference(const CUBIC_T& cubicX, const CUBIC_T& cubicY, const CUBIC_T& cubicWidth,
+                                         float dt, uint32 count,
+                                         float* outX, float* outY, float* outWidth);
+   
+   // The number of straight steps needed so that drawing the (x,y) curve
+   // as a polyline strays no more than tolerancePixels from the curve.
+   // This uses the standard bound for approximating a curve with chords:
+   //
+   //    error <= max|f''(t)| / (8*steps^2)
+   //
+   // and f''(t) = 2*c2 + 6*c3*t is a straight line, so its largest value
+   // is at t = 0 or t = 1.  Straight segments need 1 step.
+   static uint32 FlatnessSteps(const CUBIC_T& cubicX, const CUBIC_T& cubicY, float tolerancePixels);
+   
+   // "SSE2", "NEON" or "Scalar".
+   static const char* GetKernelName();
+};
+
+#endif /* defined(__ToolsDemo__SplineKernels__) */
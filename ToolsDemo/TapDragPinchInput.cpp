@@ -60,6 +60,7 @@ TapDragPinchInput::~TapDragPinchInput()
 
 void TapDragPinchInput::DrawDebug()
 {
+   Notifier::Channel<Notifier::NE_DEBUG_LINE_DRAW_ADD_LINE_PIXELS> debugLines;
    LINE_PIXELS_DATA ld;
    
    ld.color = ccc4f(0.4f, 0.75f, 0.1f, 0.90f);
@@ -73,16 +74,16 @@ void TapDragPinchInput::DrawDebug()
          // Draw two lines as a cross where the finger is down.
          ld.start = ccp(_points[0].pos.x-50,_points[0].pos.y-50);
          ld.end = ccp(_points[0].pos.x+50,_points[0].pos.y+50);
-         Notifier::Instance().Notify(Notifier::NE_DEBUG_LINE_DRAW_ADD_LINE_PIXELS, &ld);
+         debugLines.Notify(ld);
          ld.start = ccp(_points[0].pos.x+50,_points[0].pos.y-50);
          ld.end = ccp(_points[0].pos.x-50,_points[0].pos.y+50);
-         Notifier::Instance().Notify(Notifier::NE_DEBUG_LINE_DRAW_ADD_LINE_PIXELS, &ld);
+         debugLines.Notify(ld);
          break;
       case DPT_DRAG:
       case DPT_PINCH:
          ld.start = ccp(_points[0].pos.x,_points[0].pos.y);
          ld.end = ccp(_points[1].pos.x,_points[1].pos.y);
-         Notifier::Instance().Notify(Notifier::NE_DEBUG_LINE_DRAW_ADD_LINE_PIXELS, &ld);
+         debugLines.Notify(ld);
          break;
       default:
          assert(false);
@@ -0,0 +1,274 @@
+/********************************************************************
+ * File   : TiledCanvas.cpp
+ * Project: ToolsDemo
+ *
+ ********************************************************************
+ * Created on 10/20/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any 
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any 
+ * purpose, including commercial applications, and to alter it and 
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must 
+ *    not claim that you wrote the original software. If you use this 
+ *    software in a product, an acknowledgment in the product 
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and 
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source 
+ *    distribution. 
+ */
+
+
+
+#include "TiledCanvas.h"
+
+// Run length encode a tile's pixels as (run length, pixel) pairs.
+static void PackPixels(const vector<uint32>& pixels, vector<uint32>& packed)
+{
+   packed.clear();
+   uint32 idx = 0;
+   while(idx < pixels.size())
+   {
+      uint32 pixel = pixels[idx];
+      uint32 run = 1;
+      while(idx + run < pixels.size() && pixels[idx+run] == pixel)
+      {
+         run++;
+      }
+      packed.push_back(run);
+      packed.push_back(pixel);
+      idx += run;
+   }
+}
+
+static void UnpackPixels(const vector<uint32>& packed, vector<uint32>& pixels)
+{
+   uint32 pixelIdx = 0;
+   for(uint32 idx = 0; idx+1 < packed.size(); idx += 2)
+   {
+      uint32 run = packed[idx];
+      uint32 pixel = packed[idx+1];
+      assert(pixelIdx + run <= pixels.size());
+      std::fill(pixels.begin()+pixelIdx, pixels.begin()+pixelIdx+run, pixel);
+      pixelIdx += run;
+   }
+   assert(pixelIdx == pixels.size());
+}
+
+
+TiledCanvas::TiledCanvas() :
+   _maxResidentTiles(DEFAULT_MAX_RESIDENT_TILES),
+   _residentTiles(0),
+   _useCount(0),
+   _tileSize(TILE_PIXELS),
+   _visibleRect(CCRectZero),
+   _drawingTile(NULL)
+{
+   
+}
+
+TiledCanvas::~TiledCanvas()
+{
+   
+}
+
+bool TiledCanvas::init(uint32 maxResidentTiles)
+{
+   if(!CCNode::init())
+      return false;
+   if(maxResidentTiles == 0)
+   {
+      throw std::out_of_range("maxResidentTiles == 0");
+   }
+   _maxResidentTiles = maxResidentTiles;
+   // Tiles are TILE_PIXELS device pixels on a side.
+   _tileSize = TILE_PIXELS/CC_CONTENT_SCALE_FACTOR();
+   _pixels.resize(TILE_PIXELS*TILE_PIXELS);
+   return true;
+}
+
+TiledCanvas* TiledCanvas::create(uint32 maxResidentTiles)
+{
+   TiledCanvas *pRet = new TiledCanvas();
+   if (pRet && pRet->init(maxResidentTiles))
+   {
+      pRet->autorelease();
+      return pRet;
+   }
+   else
+   {
+      CC_SAFE_DELETE(pRet);
+      return NULL;
+   }
+}
+
+void TiledCanvas::GetTileKeys(const CCRect& rect, vector<TILE_KEY_T>& keys) const
+{
+   keys.clear();
+   if(rect.size.width <= 0 || rect.size.height <= 0)
+   {
+      return;
+   }
+   int32 x0 = (int32)floorf(rect.getMinX()/_tileSize);
+   int32 y0 = (int32)floorf(rect.getMinY()/_tileSize);
+   // A rect that ends right on a tile edge does not touch the next tile.
+   int32 x1 = MAX(x0, (int32)ceilf(rect.getMaxX()/_tileSize)-1);
+   int32 y1 = MAX(y0, (int32)ceilf(rect.getMaxY()/_tileSize)-1);
+   for(int32 y = y0; y <= y1; y++)
+   {
+      for(int32 x = x0; x <= x1; x++)
+      {
+         keys.push_back(TILE_KEY_T(x,y));
+      }
+   }
+}
+
+CCRect TiledCanvas::GetTileRect(const TILE_KEY_T& key) const
+{
+   return CCRect(key.first*_tileSize, key.second*_tileSize, _tileSize, _tileSize);
+}
+
+bool TiledCanvas::IsVisible(const TILE_KEY_T& key) const
+{
+   return GetTileRect(key).intersectsRect(_visibleRect);
+}
+
+CCRenderTexture* TiledCanvas::CreateTileTexture(const TILE_KEY_T& key)
+{
+   // A new render texture is already clear.
+   CCRenderTexture* texture = CCRenderTexture::create((int)_tileSize, (int)_tileSize, kCCTexture2DPixelFormat_RGBA8888);
+   assert(texture != NULL);
+   // The render texture shows its sprite centered on its position.
+   CCRect rect = GetTileRect(key);
+   texture->setPosition(ccp(rect.getMidX(), rect.getMidY()));
+   texture->setVisible(IsVisible(key));
+   addChild(texture);
+   return texture;
+}
+
+void TiledCanvas::MakeResident(const TILE_KEY_T& key, TILE_T& tile)
+{
+   if(tile.texture != NULL)
+   {
+      return;
+   }
+   tile.texture = CreateTileTexture(key);
+   _residentTiles++;
+   if(!tile.packedPixels.empty())
+   {  // Put back what was there when it was evicted.
+      UnpackPixels(tile.packedPixels, _pixels);
+      ccGLBindTexture2D(tile.texture->getSprite()->getTexture()->getName());
+      glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, TILE_PIXELS, TILE_PIXELS, GL_RGBA, GL_UNSIGNED_BYTE, &_pixels[0]);
+      // Give the memory back.
+      vector<uint32>().swap(tile.packedPixels);
+   }
+}
+
+void TiledCanvas::Evict(TILE_T& tile)
+{
+   assert(tile.texture != NULL);
+   assert(tile.texture != _drawingTile);
+   tile.texture->begin();
+   glReadPixels(0, 0, TILE_PIXELS, TILE_PIXELS, GL_RGBA, GL_UNSIGNED_BYTE, &_pixels[0]);
+   tile.texture->end();
+   PackPixels(_pixels, tile.packedPixels);
+   removeChild(tile.texture, true);
+   tile.texture = NULL;
+   _residentTiles--;
+}
+
+void TiledCanvas::EnforceResidentLimit()
+{
+   while(_residentTiles > _maxResidentTiles)
+   {
+      TILE_MAP_T::iterator oldest = _tiles.end();
+      for(TILE_MAP_T::iterator iter = _tiles.begin(); iter != _tiles.end(); ++iter)
+      {
+         const TILE_T& tile = iter->second;
+         if(tile.texture == NULL || IsVisible(iter->first))
+         {
+            continue;
+         }
+         if(oldest == _tiles.end() || tile.lastUsed < oldest->second.lastUsed)
+         {
+            oldest = iter;
+         }
+      }
+      if(oldest == _tiles.end())
+      {  // Everything left is on the screen.
+         break;
+      }
+      Evict(oldest->second);
+   }
+}
+
+void TiledCanvas::BeginTile(const TILE_KEY_T& key)
+{
+   assert(_drawingTile == NULL);
+   TILE_MAP_T::iterator iter = _tiles.find(key);
+   if(iter == _tiles.end())
+   {
+      TILE_T tile;
+      tile.texture = NULL;
+      tile.lastUsed = 0;
+      iter = _tiles.insert(TILE_MAP_T::value_type(key, tile)).first;
+   }
+   TILE_T& tile = iter->second;
+   tile.lastUsed = ++_useCount;
+   MakeResident(key, tile);
+   _drawingTile = tile.texture;
+   // begin() starts the model view over, so move the tile's corner of
+   // the canvas to the texture's origin.
+   _drawingTile->begin();
+   CCRect rect = GetTileRect(key);
+   kmGLMatrixMode(KM_GL_MODELVIEW);
+   kmGLTranslatef(-rect.getMinX(), -rect.getMinY(), 0);
+}
+
+void TiledCanvas::EndTile()
+{
+   assert(_drawingTile != NULL);
+   _drawingTile->end();
+   _drawingTile = NULL;
+   EnforceResidentLimit();
+}
+
+void TiledCanvas::SetVisibleRect(const CCRect& rect)
+{
+   _visibleRect = rect;
+   for(TILE_MAP_T::iterator iter = _tiles.begin(); iter != _tiles.end(); ++iter)
+   {
+      TILE_T& tile = iter->second;
+      bool visible = IsVisible(iter->first);
+      if(visible)
+      {
+         tile.lastUsed = ++_useCount;
+         MakeResident(iter->first, tile);
+      }
+      if(tile.texture != NULL)
+      {
+         tile.texture->setVisible(visible);
+      }
+   }
+   EnforceResidentLimit();
+}
+
+void TiledCanvas::Clear()
+{
+   assert(_drawingTile == NULL);
+   for(TILE_MAP_T::iterator iter = _tiles.begin(); iter != _tiles.end(); ++iter)
+   {
+      if(iter->second.texture != NULL)
+      {
+         removeChild(iter->second.texture, true);
+      }
+   }
+   _tiles.clear();
+   _residentTiles = 0;
+}
@@ -0,0 +1,123 @@
+/********************************************************************
+ * File   : TiledCanvas.h
+ * Project: ToolsDemo
+ *
+ ********************************************************************
+ * Created on 10/20/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any 
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any 
+ * purpose, including commercial applications, and to alter it and 
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must 
+ *    not claim that you wrote the original software. If you use this 
+ *    software in a product, an acknowledgment in the product 
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and 
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source 
+ *    distribution. 
+ */
+
+
+#ifndef __ToolsDemo__TiledCanvas__
+#define __ToolsDemo__TiledCanvas__
+
+#include "CommonSTL.h"
+#include "CommonProject.h"
+
+/* A canvas with no edges, kept as square render texture tiles that
+ * are made the first time something is drawn on them.  Positions are
+ * in canvas points; tile (0,0) has its lower left corner at the origin.
+ *
+ * Only so many tiles are kept on the GPU.  When there are more, the
+ * least recently used tile that is not on the screen is read back and
+ * kept in memory run length encoded (strokes are mostly transparent
+ * pixels, so this packs well), and put back on the GPU when it is
+ * drawn on or scrolls into view again.
+ *
+ * The tiles are children of the canvas, so moving or scaling the canvas
+ * (or its parent) pans and zooms the whole thing without redrawing it.
+ */
+class TiledCanvas : public CCNode
+{
+public:
+   typedef pair<int32,int32> TILE_KEY_T;
+   
+   enum
+   {
+      TILE_PIXELS = 256,
+      DEFAULT_MAX_RESIDENT_TILES = 96
+   };
+   
+private:
+   typedef struct
+   {
+      // NULL while the tile is evicted.
+      CCRenderTexture* texture;
+      // (run length, pixel) pairs while the tile is evicted.
+      vector<uint32> packedPixels;
+      // When the tile was last drawn on or on the screen.
+      uint32 lastUsed;
+   } TILE_T;
+   
+   typedef map<TILE_KEY_T,TILE_T> TILE_MAP_T;
+   
+   TILE_MAP_T _tiles;
+   uint32 _maxResidentTiles;
+   uint32 _residentTiles;
+   uint32 _useCount;
+   // Size of a tile in points.
+   float _tileSize;
+   // The part of the canvas on the screen.
+   CCRect _visibleRect;
+   // The tile between BeginTile(...) and EndTile().
+   CCRenderTexture* _drawingTile;
+   // Scratch space for moving a tile's pixels on and off the GPU.
+   vector<uint32> _pixels;
+   
+   TiledCanvas();
+   ~TiledCanvas();
+   bool init(uint32 maxResidentTiles);
+   
+   CCRenderTexture* CreateTileTexture(const TILE_KEY_T& key);
+   void MakeResident(const TILE_KEY_T& key, TILE_T& tile);
+   void Evict(TILE_T& tile);
+   // Evict tiles, oldest first, until there are no more than the limit
+   // or only tiles on the screen are left.
+   void EnforceResidentLimit();
+   bool IsVisible(const TILE_KEY_T& key) const;
+   
+public:
+   static TiledCanvas* create(uint32 maxResidentTiles = DEFAULT_MAX_RESIDENT_TILES);
+   
+   float GetTileSize() const { return _tileSize; }
+   // The keys of all the tiles that rect (in canvas points) touches,
+   // whether they have been made yet or not.
+   void GetTileKeys(const CCRect& rect, vector<TILE_KEY_T>& keys) const;
+   CCRect GetTileRect(const TILE_KEY_T& key) const;
+   
+   // Draw on a tile.  Everything drawn between BeginTile(...) and
+   // EndTile() goes into the tile, with canvas points mapped to the
+   // right place in it.  The tile is made (or put back on the GPU) if
+   // it needs to be.
+   void BeginTile(const TILE_KEY_T& key);
+   void EndTile();
+   
+   // Tell the canvas which part of it is on the screen, so only those
+   // tiles are drawn and they are kept on the GPU.  Call once a frame.
+   void SetVisibleRect(const CCRect& rect);
+   
+   // Throw away all the tiles.
+   void Clear();
+   
+   uint32 GetTileCount() const { return _tiles.size(); }
+   uint32 GetResidentTileCount() const { return _residentTiles; }
+};
+
+#endif /* defined(__ToolsDemo__TiledCanvas__) */
@@ -0,0 +1,183 @@
+/********************************************************************
+ * File   : WorkerPool.cpp
+ * Project: ToolsDemo
+ *
+ ********************************************************************
+ * Created on 10/19/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+#include "WorkerPool.h"
+#include <unistd.h>
+
+WorkerPool::WorkerPool() :
+   _initialized(false),
+   _shutdown(false),
+   _generation(0),
+   _startGeneration(0),
+   _busyWorkers(0),
+   _func(NULL),
+   _context(NULL),
+   _count(0),
+   _nextIndex(0)
+{
+   
+}
+
+WorkerPool::~WorkerPool()
+{
+   Shutdown();
+}
+
+void WorkerPool::Init(uint32 threadCount)
+{
+   assert(!_initialized);
+   pthread_mutex_init(&_mutex, NULL);
+   pthread_cond_init(&_workReady, NULL);
+   pthread_cond_init(&_workDone, NULL);
+   _initialized = true;
+   _shutdown = false;
+   _startGeneration = _generation;
+   for(uint32 idx = 0; idx < threadCount; idx++)
+   {
+      pthread_t thread;
+      if(pthread_create(&thread, NULL, WorkerMain, this) != 0)
+      {  // Run with however many we got.
+         break;
+      }
+      _threads.push_back(thread);
+   }
+}
+
+void WorkerPool::Shutdown()
+{
+   if(!_initialized)
+   {
+      return;
+   }
+   pthread_mutex_lock(&_mutex);
+   _shutdown = true;
+   pthread_cond_broadcast(&_workReady);
+   pthread_mutex_unlock(&_mutex);
+   for(uint32 idx = 0; idx < _threads.size(); idx++)
+   {
+      pthread_join(_threads[idx], NULL);
+   }
+   _threads.clear();
+   pthread_cond_destroy(&_workDone);
+   pthread_cond_destroy(&_workReady);
+   pthread_mutex_destroy(&_mutex);
+   _initialized = false;
+}
+
+void* WorkerPool::WorkerMain(void* arg)
+{
+   ((WorkerPool*)arg)->WorkerLoop();
+   return NULL;
+}
+
+void WorkerPool::WorkerLoop()
+{
+   pthread_mutex_lock(&_mutex);
+   uint32 seenGeneration = _startGeneration;
+   while(true)
+   {
+      while(_generation == seenGeneration && !_shutdown)
+      {
+         pthread_cond_wait(&_workReady, &_mutex);
+      }
+      if(_shutdown)
+      {
+         break;
+      }
+      seenGeneration = _generation;
+      pthread_mutex_unlock(&_mutex);
+      
+      RunItems();
+      
+      pthread_mutex_lock(&_mutex);
+      assert(_busyWorkers > 0);
+      _busyWorkers--;
+      if(_busyWorkers == 0)
+      {
+         pthread_cond_signal(&_workDone);
+      }
+   }
+   pthread_mutex_unlock(&_mutex);
+}
+
+void WorkerPool::RunItems()
+{
+   while(true)
+   {
+      uint32 index = __sync_fetch_and_add(&_nextIndex, 1);
+      if(index >= _count)
+      {
+         break;
+      }
+      _func(_context, index);
+   }
+}
+
+void WorkerPool::ParallelFor(uint32 count, ITEM_FUNC_T func, void* context)
+{
+   if(func == NULL)
+   {
+      throw std::out_of_range("func == NULL");
+   }
+   if(count == 0)
+   {
+      return;
+   }
+   if(!_initialized || _threads.empty() || count == 1)
+   {  // Nobody to share with.
+      for(uint32 idx = 0; idx < count; idx++)
+      {
+         func(context, idx);
+      }
+      return;
+   }
+   
+   pthread_mutex_lock(&_mutex);
+   assert(_busyWorkers == 0);
+   _func = func;
+   _context = context;
+   _count = count;
+   _nextIndex = 0;
+   _busyWorkers = _threads.size();
+   _generation++;
+   pthread_cond_broadcast(&_workReady);
+   pthread_mutex_unlock(&_mutex);
+   
+   RunItems();
+   
+   pthread_mutex_lock(&_mutex);
+   while(_busyWorkers > 0)
+   {
+      pthread_cond_wait(&_workDone, &_mutex);
+   }
+   pthread_mutex_unlock(&_mutex);
+}
+
+uint32 WorkerPool::GetProcessorCount()
+{
+   long count = sysconf(_SC_NPROCESSORS_ONLN);
+   return count < 1 ? 1 : (uint32)count;
+}
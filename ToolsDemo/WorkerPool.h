@@ -0,0 +1,110 @@
+/********************************************************************
+ * File   : WorkerPool.h
+ * Project: ToolsDemo
+ *
+ ********************************************************************
+ * Created on 10/19/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+#ifndef __ToolsDemo__WorkerPool__
+#define __ToolsDemo__WorkerPool__
+
+#include "CommonSTL.h"
+#include <pthread.h>
+
+/* A small pool of worker threads for "do this for every item" jobs
+ * (e.g. post processing finished strokes before they are drawn).
+ *
+ * Usage:
+ *    WorkerPool pool;
+ *    pool.Init(WorkerPool::GetProcessorCount()-1);
+ *    ...
+ *    pool.ParallelFor(count, DoItem, &myData);   // calls DoItem(&myData, 0..count-1)
+ *    ...
+ *    pool.Shutdown();   // Or let the destructor do it.
+ *
+ * ParallelFor(...) does not return until every item is done.  The
+ * calling thread works on items too, so Init(0) is legal and simply
+ * runs everything on the caller.  Items are handed out one at a time
+ * from a shared counter, so uneven items balance out.
+ *
+ * The threads are created once in Init(...) and sleep between jobs,
+ * so a job costs a wakeup, not a thread creation.
+ *
+ * Only one thread may call ParallelFor(...) at a time, and the item
+ * function must not call ParallelFor(...) on the same pool.
+ */
+class WorkerPool
+{
+public:
+   typedef void (*ITEM_FUNC_T)(void* context, uint32 index);
+   
+private:
+   vector<pthread_t> _threads;
+   pthread_mutex_t _mutex;
+   pthread_cond_t _workReady;
+   pthread_cond_t _workDone;
+   bool _initialized;
+   bool _shutdown;
+   // Bumped for every job so sleeping workers can tell a new job from a
+   // spurious wakeup.
+   uint32 _generation;
+   // _generation when Init(...) ran.  Workers start from this rather than
+   // reading _generation themselves, or one that starts after the first
+   // ParallelFor(...) would sleep through it.
+   uint32 _startGeneration;
+   // Workers still busy with the current job.
+   uint32 _busyWorkers;
+   
+   // The current job.
+   ITEM_FUNC_T _func;
+   void* _context;
+   uint32 _count;
+   volatile uint32 _nextIndex;
+   
+   static void* WorkerMain(void* arg);
+   void WorkerLoop();
+   void RunItems();
+   
+   // Not copyable.
+   WorkerPool(const WorkerPool&);
+   WorkerPool& operator=(const WorkerPool&);
+   
+public:
+   WorkerPool();
+   ~WorkerPool();
+   
+   // Start threadCount worker threads (in addition to the caller).
+   void Init(uint32 threadCount);
+   // Stop and join the worker threads.
+   void Shutdown();
+   
+   uint32 GetThreadCount() const { return _threads.size(); }
+   
+   // Call func(context, idx) for idx = 0..count-1 and wait for all of
+   // them to finish.
+   void ParallelFor(uint32 count, ITEM_FUNC_T func, void* context);
+   
+   // The number of cores online (at least 1).
+   static uint32 GetProcessorCount();
+};
+
+#endif /* defined(__ToolsDemo__WorkerPool__) */